@@ -1,5 +1,11 @@
 #!/usr/bin/env python3
 
+import argparse
+import math
+import os
+import subprocess
+import sys
+
 from sympy import Symbol, Rational, apart, diff, factorial, real_roots
 import sympy
 import mpmath
@@ -109,10 +115,86 @@ def compute_exact_closed_form():
 
     return exact_closed, exact_roots, residues
 
+# 5. High-precision closed-form via the C++ evaluator
+
+# The compiled tiling_generator.cpp; `closedform` refines the roots by Newton
+# iteration at any precision, so the exact closed form reaches large N
+TILING_BIN = os.environ.get(
+    "TILING_BIN", os.path.join(os.path.dirname(os.path.abspath(__file__)), "tiling"))
+
+# log10 of the dominant 1/r_i, so a_N has about (N+1) * this many digits
+LOG10_GROWTH = math.log10(1 / 0.3111078174659819)
+
+
+def closed_form_precision(n):
+    """Significant digits that carry Σ A_i / r_i^{N+1} past the units place."""
+    return int((n + 1) * LOG10_GROWTH) + 10
+
+
+def have_closed_form_binary():
+    return os.access(TILING_BIN, os.X_OK)
+
+
+def closed_form_value(n, precision):
+    """Σ A_i / r_i^{N+1} to `precision` significant digits, as a decimal string."""
+    result = subprocess.run(
+        [TILING_BIN, "closedform", str(n), "--precision", str(precision), "--format=value"],
+        capture_output=True, text=True, check=True)
+    return result.stdout.strip()
+
+
+def tiling_closed_form(n):
+    """Compute a_N by rounding the closed form, evaluated by `tiling closedform`."""
+    value = closed_form_value(n, closed_form_precision(n))
+    whole, _, frac = value.partition(".")
+    return int(whole) + (1 if frac[:1] >= "5" else 0)
+
+
+# Big multiplies from many threads at once, at sizes where the NTT product
+# kicks in and the transforms differ in length between tasks
+THREADED_VERIFY_N = 100000
+THREADED_VERIFY_THREADS = 16
+
+
+def threaded_verify():
+    """Run `tiling verify` on matpow and Kitamasa with many threads; True if it passes."""
+    result = subprocess.run(
+        [TILING_BIN, "verify", str(THREADED_VERIFY_N), "--threads", str(THREADED_VERIFY_THREADS),
+         "--engines=matpow,kitamasa"],
+        capture_output=True, text=True)
+    for line in result.stdout.splitlines():
+        if "MISMATCH" in line:
+            print(f"    {line.strip()}")
+    return result.returncode == 0
+
+
+def sample_points(max_n):
+    """N = 20, 50, 100, 200, 500, ... up to max_n (and max_n itself)."""
+    points = []
+    scale = 10
+    while True:
+        for step in (2, 5, 10):
+            n = step * scale
+            if n > max_n:
+                if not points or points[-1] != max_n:
+                    points.append(max_n)
+                return points
+            points.append(n)
+        scale *= 10
+
+
 # Output
 
 def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--max-n", type=int, default=15,
+                        help="extend the closed-form and error tables to this N (default 15)")
+    args = parser.parse_args()
+
     MAX_N = 15
+    large_n = sample_points(args.max_n) if args.max_n > MAX_N else []
+    if hasattr(sys, "set_int_max_str_digits"):
+        sys.set_int_max_str_digits(0)  # a_N at large N has more digits than the default limit
 
     print("=" * 80)
     print("  TILING ANALYSIS: 2×N Floor with 1×1 and 2×1 Tiles")
@@ -131,6 +213,12 @@ def main():
     print()
 
     exact_closed, exact_roots, residues = compute_exact_closed_form()
+    if have_closed_form_binary():
+        exact_closed = tiling_closed_form
+    elif large_n:
+        print(f"  {TILING_BIN} not found; compile tiling_generator.cpp to reach N > {MAX_N}")
+        print()
+        large_n = []
 
     # Comparison table
     print("─" * 80)
@@ -164,6 +252,28 @@ def main():
 
     print()
 
+    # The closed form at large N, against the recurrence
+    if large_n:
+        a_large = tiling_recurrence(large_n[-1])
+        print(f"  Exact closed form (via {os.path.basename(TILING_BIN)} closedform) at larger N:")
+        print()
+        print(f"  {'N':>8} | {'Digits of a_N':>13} | {'Precision':>9} | Exact CF == Recurrence")
+        print("  " + "-" * 60)
+        for n in large_n:
+            cf_val = tiling_closed_form(n)
+            match = cf_val == a_large[n]
+            print(f"  {n:>8} | {len(str(a_large[n])):>13} | {closed_form_precision(n):>9} | "
+                  f"{'OK' if match else 'MISMATCH'}")
+            assert match, f"Exact CF mismatch at N={n}"
+        print()
+
+        print(f"  {os.path.basename(TILING_BIN)} verify {THREADED_VERIFY_N} "
+              f"--threads {THREADED_VERIFY_THREADS} --engines=matpow,kitamasa:")
+        passed = threaded_verify()
+        print(f"    {'OK' if passed else 'FAILED'}")
+        assert passed, "threaded bignum verification failed"
+        print()
+
     if breakdown_n is not None:
         print(f"  ⚠ Approximate closed-form breaks down at N={breakdown_n}")
         print(f"    (rounded approximation gives {round(tiling_approx(breakdown_n))}, "
@@ -190,8 +300,8 @@ def main():
     print(f"  {'N':>3} | {'Absolute Error':>25} | {'Relative Error':>25}")
     print("  " + "-" * 60)
 
-    a_vals = tiling_recurrence(MAX_N)
-    for n in range(MAX_N + 1):
+    a_vals = tiling_recurrence(max([MAX_N] + large_n))
+    for n in list(range(MAX_N + 1)) + large_n:
         approx = mpmath.mpf(0)
         for coeff, root in zip(APPROX_COEFFS, APPROX_ROOTS):
             approx += mpmath.mpf(coeff) / mpmath.power(mpmath.mpf(root), n + 1)
@@ -5,252 +5,4948 @@
 #include <iomanip>
 #include <algorithm>
 #include <map>
+#include <tuple>
+#include <deque>
+#include <memory>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <charconv>
+#include <random>
+#include <sstream>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+#include <climits>
+#include <cmath>
+#include <cctype>
+#include <csignal>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+
+// Allocation counting
+//
+// Global operator new is replaced by a thin wrapper around malloc that
+// counts calls and bytes, so `bench` can report allocations per operation.
+// The counters are relaxed atomics: one uncontended increment per
+// allocation, next to the cost of malloc itself.
+// ---------------------------------------------------------------------------
+std::atomic<uint64_t> g_allocations(0), g_allocated_bytes(0);
+
+void* counted_alloc(std::size_t n) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocated_bytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t n) { return counted_alloc(n); }
+void* operator new[](std::size_t n) { return counted_alloc(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// Instrumentation
+//
+// With --stats a command reports on stderr how many DFS nodes the Enumerator
+// visited, how many cells find_next_empty scanned, how many DP transitions
+// were applied, and how many bytes were written. It also reports wall and CPU
+// time split by phase. Counters are thread_local, so on the hot paths they are
+// plain integer increments. Worker threads fold theirs into a shared total
+// when they finish.
+//
+// A PhaseTimer moves its thread into a phase for its lifetime and back to the
+// enclosing phase afterwards. Time is credited exclusively: a format call
+// nested in a search is not also counted as search. The clocks are read only
+// after --stats has switched timing on. Each switch then reads the monotonic
+// clock. Thread CPU time, a system call, is read at most once a millisecond
+// and split across the phases in proportion to their wall time since the
+// last reading. Building with -DTILING_STATS=0 removes the counters and
+// timers; --stats then only says so.
+// ---------------------------------------------------------------------------
+#ifndef TILING_STATS
+#define TILING_STATS 1
+#endif
+
+enum StatsPhase { kPhaseOther, kPhaseDp, kPhaseCounting, kPhaseSearch, kPhaseFormat, kPhaseOutput, kPhaseCount };
+
+#if TILING_STATS
+const char* const kPhaseNames[kPhaseCount] = {"other", "dp", "counting", "search", "format", "output"};
+
+struct StatsCounters {
+    uint64_t dfs_nodes = 0, empty_scans = 0, scanned_cells = 0, dp_transitions = 0, bytes_written = 0;
+    uint64_t entries[kPhaseCount] = {};
+    double wall[kPhaseCount] = {}, cpu[kPhaseCount] = {};
+
+    void add(const StatsCounters& o) {
+        dfs_nodes += o.dfs_nodes;
+        empty_scans += o.empty_scans;
+        scanned_cells += o.scanned_cells;
+        dp_transitions += o.dp_transitions;
+        bytes_written += o.bytes_written;
+        for (int p = 0; p < kPhaseCount; p++) {
+            entries[p] += o.entries[p];
+            wall[p] += o.wall[p];
+            cpu[p] += o.cpu[p];
+        }
+    }
+};
+
+bool g_stats_timing = false;  // set once by main, before any thread starts
+thread_local StatsCounters t_stats;
+thread_local int t_phase = kPhaseOther;
+thread_local double t_phase_wall = -1;  // when t_phase was entered
+thread_local double t_sample_wall = 0, t_sample_cpu = 0;  // the last thread CPU reading
+thread_local double t_unsampled[kPhaseCount];  // wall time per phase since that reading
+
+const double kStatsCpuSampleSeconds = 1e-3;
+
+std::mutex g_stats_mutex;
+StatsCounters g_stats_total;
+
+#define STAT_ADD(field, n) (t_stats.field += (n))
+
+double clock_seconds(clockid_t id) {
+    timespec ts;
+    clock_gettime(id, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Split the thread CPU time since the last reading across the phases, in
+// proportion to the wall time each spent since then
+void stats_sample_cpu(double wall) {
+    double cpu = clock_seconds(CLOCK_THREAD_CPUTIME_ID), span = 0;
+    for (int p = 0; p < kPhaseCount; p++) span += t_unsampled[p];
+    for (int p = 0; p < kPhaseCount; p++) {
+        if (span > 0) t_stats.cpu[p] += (cpu - t_sample_cpu) * (t_unsampled[p] / span);
+        t_unsampled[p] = 0;
+    }
+    t_sample_wall = wall;
+    t_sample_cpu = cpu;
+}
+
+// Credit the time since the last switch to the current phase, then enter
+// `phase`; a final switch passes sample to settle the CPU time
+void stats_switch(int phase, bool sample = false) {
+    double wall = clock_seconds(CLOCK_MONOTONIC);
+    if (t_phase_wall >= 0) {
+        t_stats.wall[t_phase] += wall - t_phase_wall;
+        t_unsampled[t_phase] += wall - t_phase_wall;
+        if (sample || wall - t_sample_wall >= kStatsCpuSampleSeconds) stats_sample_cpu(wall);
+    } else {
+        stats_sample_cpu(wall);
+    }
+    t_phase = phase;
+    t_phase_wall = wall;
+}
+
+class PhaseTimer {
+public:
+    explicit PhaseTimer(StatsPhase phase) : prev(-1) {
+        if (!g_stats_timing || phase == t_phase) return;
+        prev = t_phase;
+        t_stats.entries[phase]++;
+        stats_switch(phase);
+    }
+    ~PhaseTimer() {
+        if (prev >= 0) stats_switch(prev);
+    }
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    int prev;
+};
+
+// Fold this thread's counters into the shared total; workers call it last
+void stats_flush() {
+    if (g_stats_timing) stats_switch(t_phase, true);
+    std::lock_guard<std::mutex> lock(g_stats_mutex);
+    g_stats_total.add(t_stats);
+    t_stats = StatsCounters();
+}
+
+// Counts the bytes passing through std::cout on their way to its own buffer
+class CountingStreambuf : public std::streambuf {
+public:
+    explicit CountingStreambuf(std::streambuf* inner) : inner(inner) {}
+
+protected:
+    int overflow(int c) override {
+        if (c == EOF) return inner->pubsync() == 0 ? 0 : EOF;
+        STAT_ADD(bytes_written, 1);
+        return inner->sputc(char(c));
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        STAT_ADD(bytes_written, n);
+        return inner->sputn(s, n);
+    }
+    int sync() override { return inner->pubsync(); }
+
+private:
+    std::streambuf* inner;
+};
+
+// Switches instrumentation on for the life of main and prints the report
+class StatsReport {
+public:
+    explicit StatsReport(bool on) : on(on), counting(std::cout.rdbuf()), saved(nullptr) {
+        if (!on) return;
+        g_stats_timing = true;
+        stats_switch(kPhaseOther);
+        saved = std::cout.rdbuf(&counting);
+        start_wall = clock_seconds(CLOCK_MONOTONIC);
+        start_allocations = g_allocations.load();
+        start_allocated = g_allocated_bytes.load();
+    }
+    ~StatsReport() {
+        if (!on) return;
+        std::cout.flush();
+        std::cout.rdbuf(saved);
+        stats_flush();
+        double wall = clock_seconds(CLOCK_MONOTONIC) - start_wall;
+        double cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+        print(g_stats_total, wall, cpu, g_allocations.load() - start_allocations,
+              g_allocated_bytes.load() - start_allocated);
+    }
+    StatsReport(const StatsReport&) = delete;
+    StatsReport& operator=(const StatsReport&) = delete;
+
+private:
+    bool on;
+    CountingStreambuf counting;
+    std::streambuf* saved;
+    double start_wall = 0;
+    uint64_t start_allocations = 0, start_allocated = 0;
+
+    static void print(const StatsCounters& s, double wall, double cpu, uint64_t allocations, uint64_t allocated) {
+        std::ostream& os = std::cerr;
+        os << "\nStatistics:\n"
+           << "  DFS nodes:          " << s.dfs_nodes << "\n"
+           << "  empty-cell scans:   " << s.empty_scans << " (" << s.scanned_cells << " cells)\n"
+           << "  DP transitions:     " << s.dp_transitions << "\n"
+           << "  bytes written:      " << s.bytes_written << "\n"
+           << "  heap allocations:   " << allocations << " (" << allocated << " bytes)\n"
+           << "  phase        entries     wall (s)      CPU (s)\n";
+        os << std::fixed << std::setprecision(6);
+        for (int p = 0; p < kPhaseCount; p++) {
+            if (p != kPhaseOther && s.entries[p] == 0) continue;
+            os << "  " << std::left << std::setw(10) << kPhaseNames[p] << std::right << std::setw(10)
+               << s.entries[p] << std::setw(13) << s.wall[p] << std::setw(13) << s.cpu[p] << "\n";
+        }
+        os << "  " << std::left << std::setw(20) << "total" << std::right << std::setw(13) << wall
+           << std::setw(13) << cpu << "\n";
+        os << "  (phase times are summed over threads; total CPU is the whole process)\n";
+    }
+};
+#else
+#define STAT_ADD(field, n) ((void)0)
+
+class PhaseTimer {
+public:
+    explicit PhaseTimer(StatsPhase) {}
+};
+
+inline void stats_flush() {}
+
+class StatsReport {
+public:
+    explicit StatsReport(bool on) {
+        if (on) std::cerr << "Statistics are compiled out of this build (TILING_STATS=0)\n";
+    }
+};
+#endif
+
+// Arbitrary-precision integers
+//
+// Unsigned magnitude stored as little-endian base-2^32 limbs, with no leading
+// zero limbs (zero is the empty vector). Tiling counts are never negative, so
+// subtraction requires a >= b. Assigning a small value or stepping the
+// recurrence in place reuses the existing limb storage, so a long run of
+// recurrence steps allocates only when a value outgrows its capacity.
+// ---------------------------------------------------------------------------
+class BigInt {
+public:
+    BigInt() {}
+    BigInt(unsigned long long v) { *this = v; }
+    explicit BigInt(std::vector<uint32_t> l) : limbs(std::move(l)) { trim(); }
+
+    BigInt& operator=(unsigned long long v) {
+        limbs.clear();
+        for (; v != 0; v >>= 32) limbs.push_back(uint32_t(v));
+        return *this;
+    }
+
+    bool is_zero() const { return limbs.empty(); }
+    size_t size() const { return limbs.size(); }
+    const std::vector<uint32_t>& data() const { return limbs; }
+
+    BigInt& operator+=(const BigInt& b) {
+        if (limbs.size() < b.limbs.size()) limbs.resize(b.limbs.size(), 0);
+        uint64_t carry = 0;
+        size_t i = 0;
+        for (; i < b.limbs.size(); i++) {
+            carry += uint64_t(limbs[i]) + b.limbs[i];
+            limbs[i] = uint32_t(carry);
+            carry >>= 32;
+        }
+        for (; carry != 0 && i < limbs.size(); i++) {
+            carry += limbs[i];
+            limbs[i] = uint32_t(carry);
+            carry >>= 32;
+        }
+        if (carry != 0) limbs.push_back(uint32_t(carry));
+        return *this;
+    }
+
+    // Requires *this >= b
+    BigInt& operator-=(const BigInt& b) {
+        uint64_t borrow = 0;
+        size_t i = 0;
+        for (; i < b.limbs.size(); i++) {
+            uint64_t d = uint64_t(limbs[i]) - b.limbs[i] - borrow;
+            limbs[i] = uint32_t(d);
+            borrow = d >> 63;
+        }
+        for (; borrow != 0 && i < limbs.size(); i++) {
+            uint64_t d = uint64_t(limbs[i]) - borrow;
+            limbs[i] = uint32_t(d);
+            borrow = d >> 63;
+        }
+        trim();
+        return *this;
+    }
+
+    BigInt& operator*=(uint32_t m) {
+        if (m == 0) { limbs.clear(); return *this; }
+        uint64_t carry = 0;
+        for (uint32_t& l : limbs) {
+            carry += uint64_t(l) * m;
+            l = uint32_t(carry);
+            carry >>= 32;
+        }
+        if (carry != 0) limbs.push_back(uint32_t(carry));
+        return *this;
+    }
+
+    // One recurrence step in a single pass: *this = 3*a2 + a1 - *this.
+    // The result must be non-negative, which holds for the tiling sequence.
+    void recur(const BigInt& a1, const BigInt& a2) {
+        size_t n = std::max(std::max(limbs.size(), a1.limbs.size()), a2.limbs.size());
+        size_t n1 = a1.limbs.size(), n2 = a2.limbs.size();
+        limbs.resize(n, 0);
+        const uint32_t* p1 = a1.limbs.data();
+        const uint32_t* p2 = a2.limbs.data();
+        int64_t carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            int64_t v = carry - int64_t(limbs[i]);
+            if (i < n1) v += p1[i];
+            if (i < n2) v += 3 * int64_t(p2[i]);
+            limbs[i] = uint32_t(v);
+            carry = v >> 32;  // arithmetic shift keeps the borrow sign
+        }
+        if (carry > 0) limbs.push_back(uint32_t(carry));
+        trim();
+    }
+
+    friend BigInt operator+(BigInt a, const BigInt& b) { a += b; return a; }
+    friend BigInt operator-(BigInt a, const BigInt& b) { a -= b; return a; }
+
+    // Schoolbook, Karatsuba or NTT by operand size; see mul_limbs
+    friend BigInt operator*(const BigInt& a, const BigInt& b);
+
+    friend bool operator==(const BigInt& a, const BigInt& b) { return a.limbs == b.limbs; }
+    friend bool operator!=(const BigInt& a, const BigInt& b) { return a.limbs != b.limbs; }
+    // Parse a non-empty string of decimal digits
+    static bool parse(const std::string& s, BigInt& out) {
+        if (s.empty() || s.find_first_not_of("0123456789") != std::string::npos) return false;
+        out = 0;
+        for (size_t i = 0; i < s.size(); i += 9) {
+            std::string chunk = s.substr(i, 9);
+            uint32_t scale = 1;
+            for (size_t j = 0; j < chunk.size(); j++) scale *= 10;
+            out *= scale;
+            out += BigInt(std::stoull(chunk));
+        }
+        return true;
+    }
+
+    friend bool operator<(const BigInt& a, const BigInt& b) {
+        if (a.limbs.size() != b.limbs.size()) return a.limbs.size() < b.limbs.size();
+        for (size_t i = a.limbs.size(); i-- > 0;)
+            if (a.limbs[i] != b.limbs[i]) return a.limbs[i] < b.limbs[i];
+        return false;
+    }
+
+    // Decimal string; see binary_to_decimal
+    std::string to_string() const;
+
+private:
+    std::vector<uint32_t> limbs;
+
+    void trim() {
+        while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+    }
+};
+
+std::ostream& operator<<(std::ostream& os, const BigInt& v) { return os << v.to_string(); }
+
+// Big-integer multiplication
+//
+// Products are formed by one of three kernels, chosen by the shorter operand:
+//   - schoolbook below kKaratsubaLimbs limbs,
+//   - Karatsuba (three half-size products instead of four) below kNttLimbs,
+//   - a number-theoretic transform above that: limbs are convolved modulo
+//     three NTT primes and recombined by the Chinese remainder theorem, in
+//     O(n log n).
+// A product coefficient is at most min(na, nb)·(2^32 − 1)^2, and the three
+// primes multiply to about 2^86, so the NTT handles operands up to 2^21 limbs
+// directly; larger ones are split by Karatsuba first. Very unbalanced products
+// are cut into balanced pieces.
+// ---------------------------------------------------------------------------
+typedef std::vector<uint32_t> Limbs;
+
+// Hot loops over plain arrays (the NTT butterflies, and the lane kernel of
+// count-batch) are compiled at -O3, which vectorizes them, and on x86-64 also
+// built for AVX2 and AVX-512 with the best version picked at load time.
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(__clang__)
+#define TILING_SIMD_KERNEL __attribute__((target_clones("avx512f", "avx2", "default"), optimize("O3")))
+#elif defined(__GNUC__) && !defined(__clang__)
+#define TILING_SIMD_KERNEL __attribute__((optimize("O3")))
+#else
+#define TILING_SIMD_KERNEL
+#endif
+
+const size_t kKaratsubaLimbs = 40;
+const size_t kNttLimbs = 1500;
+const size_t kNttMaxOperand = size_t(1) << 21;
+const size_t kNttMaxLength = size_t(1) << 23;  // the largest power of two every prime supports
+
+Limbs mul_limbs(const uint32_t* a, size_t na, const uint32_t* b, size_t nb);
+
+Limbs mul_schoolbook(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    Limbs r(na + nb, 0);
+    for (size_t i = 0; i < na; i++) {
+        uint64_t carry = 0, ai = a[i];
+        uint32_t* out = r.data() + i;
+        for (size_t j = 0; j < nb; j++) {
+            carry += ai * b[j] + out[j];
+            out[j] = uint32_t(carry);
+            carry >>= 32;
+        }
+        out[nb] = uint32_t(carry);
+    }
+    return r;
+}
+
+// r[offset..] += x; the sum must fit in r
+void add_limbs_at(Limbs& r, size_t offset, const Limbs& x) {
+    uint64_t carry = 0;
+    size_t i = 0, n = std::min(x.size(), r.size() - offset);
+    for (; i < n; i++) {
+        carry += uint64_t(r[offset + i]) + x[i];
+        r[offset + i] = uint32_t(carry);
+        carry >>= 32;
+    }
+    for (i += offset; carry != 0 && i < r.size(); i++) {
+        carry += r[i];
+        r[i] = uint32_t(carry);
+        carry >>= 32;
+    }
+}
+
+// x -= y for x >= y; limbs of y beyond x's length must be zero
+void sub_limbs(Limbs& x, const Limbs& y) {
+    uint64_t borrow = 0;
+    size_t i = 0, n = std::min(x.size(), y.size());
+    for (; i < n; i++) {
+        uint64_t d = uint64_t(x[i]) - y[i] - borrow;
+        x[i] = uint32_t(d);
+        borrow = d >> 63;
+    }
+    for (; borrow != 0 && i < x.size(); i++) {
+        uint64_t d = uint64_t(x[i]) - borrow;
+        x[i] = uint32_t(d);
+        borrow = d >> 63;
+    }
+}
+
+size_t trimmed(const uint32_t* a, size_t n) {
+    while (n > 0 && a[n - 1] == 0) n--;
+    return n;
+}
+
+// Requires na >= nb > na / 2; split at m = na / 2
+Limbs mul_karatsuba(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    size_t m = na / 2;
+    size_t na0 = trimmed(a, m), nb0 = trimmed(b, m);
+    Limbs z0 = mul_limbs(a, na0, b, nb0);
+    Limbs z2 = mul_limbs(a + m, na - m, b + m, nb - m);
+
+    Limbs sa(a, a + m), sb(b, b + m);
+    sa.resize(std::max(m, na - m) + 1, 0);
+    sb.resize(std::max(m, nb - m) + 1, 0);
+    add_limbs_at(sa, 0, Limbs(a + m, a + na));
+    add_limbs_at(sb, 0, Limbs(b + m, b + nb));
+    Limbs z1 = mul_limbs(sa.data(), trimmed(sa.data(), sa.size()), sb.data(), trimmed(sb.data(), sb.size()));
+    sub_limbs(z1, z0);
+    sub_limbs(z1, z2);
+
+    Limbs r(na + nb, 0);
+    add_limbs_at(r, 0, z0);
+    add_limbs_at(r, m, z1);
+    add_limbs_at(r, 2 * m, z2);
+    return r;
+}
+
+// Arithmetic modulo one NTT prime, in Montgomery form x·2^32 mod P
+struct NttPrime {
+    uint32_t P, neg_inv, r2, root;  // root: a primitive root mod P
+
+    NttPrime(uint32_t p, uint32_t g) : P(p), root(g) {
+        uint32_t inv = p;
+        for (int i = 0; i < 4; i++) inv *= 2 - p * inv;
+        neg_inv = ~inv + 1;
+        uint64_t r = (uint64_t(1) << 32) % p;
+        r2 = uint32_t(r * r % p);
+    }
+
+    uint32_t redc(uint64_t t) const {
+        uint32_t m = uint32_t(t) * neg_inv;
+        uint64_t u = (t + uint64_t(m) * P) >> 32;
+        return uint32_t(u >= P ? u - P : u);
+    }
+    uint32_t mul(uint32_t a, uint32_t b) const { return redc(uint64_t(a) * b); }
+    uint32_t to_mont(uint32_t x) const { return mul(x, r2); }  // x·r2 < 2^32·P for any x
+    uint32_t add(uint32_t a, uint32_t b) const { uint32_t s = a + b; return s >= P ? s - P : s; }
+    uint32_t sub(uint32_t a, uint32_t b) const { return a >= b ? a - b : a + P - b; }
+    uint32_t pow(uint32_t a, uint64_t e) const {
+        uint32_t r = to_mont(1);
+        for (; e > 0; e >>= 1, a = mul(a, a))
+            if (e & 1) r = mul(r, a);
+        return r;
+    }
+};
+
+// Twiddles for transforms of length n: w[len + j] = ω_{2len}^j for each
+// power of two len < n, in Montgomery form. Each (prime, direction, length)
+// gets its own table, filled once under the lock and never touched again:
+// callers read it without the lock while other threads multiply, so growing
+// a shared table in place would reallocate it under their feet. The tables
+// for all lengths up to n add up to under twice the size of the longest.
+const Limbs& ntt_twiddles(const NttPrime& F, size_t n, bool inverse) {
+    static std::mutex lock;
+    static std::map<std::tuple<uint32_t, bool, size_t>, Limbs> tables;
+    std::lock_guard<std::mutex> guard(lock);
+    Limbs& w = tables[{F.P, inverse, n}];
+    if (!w.empty()) return w;
+    w.assign(std::max<size_t>(n, 2), 0);
+    for (size_t len = 1; len < n; len <<= 1) {
+        uint32_t step = F.pow(F.to_mont(F.root), (F.P - 1) / (2 * len));
+        if (inverse) step = F.pow(step, F.P - 2);
+        uint32_t x = F.to_mont(1);
+        for (size_t j = 0; j < len; j++, x = F.mul(x, step)) w[len + j] = x;
+    }
+    return w;
+}
+
+// Decimation in frequency: natural order in, bit-reversed order out
+TILING_SIMD_KERNEL
+void ntt_forward(const NttPrime& F, const Limbs& w, uint32_t* a, size_t n) {
+    for (size_t len = n / 2; len >= 1; len >>= 1)
+        for (size_t i = 0; i < n; i += 2 * len)
+            for (size_t j = 0; j < len; j++) {
+                uint32_t u = a[i + j], v = a[i + j + len];
+                a[i + j] = F.add(u, v);
+                a[i + j + len] = F.mul(F.sub(u, v), w[len + j]);
+            }
+}
+
+// Decimation in time with inverse roots: bit-reversed in, natural out, scaled by n
+TILING_SIMD_KERNEL
+void ntt_inverse(const NttPrime& F, const Limbs& w, uint32_t* a, size_t n) {
+    for (size_t len = 1; len < n; len <<= 1)
+        for (size_t i = 0; i < n; i += 2 * len)
+            for (size_t j = 0; j < len; j++) {
+                uint32_t u = a[i + j], v = F.mul(a[i + j + len], w[len + j]);
+                a[i + j] = F.add(u, v);
+                a[i + j + len] = F.sub(u, v);
+            }
+}
+
+// Cyclic convolution of a and b modulo F.P, as plain residues
+Limbs ntt_convolve(const NttPrime& F, const uint32_t* a, size_t na, const uint32_t* b, size_t nb, size_t n) {
+    bool square = (a == b && na == nb);
+    const Limbs& w = ntt_twiddles(F, n, false);
+    const Limbs& w_inv = ntt_twiddles(F, n, true);
+    Limbs fa(n, 0), fb;
+    for (size_t i = 0; i < na; i++) fa[i] = F.to_mont(a[i]);
+    ntt_forward(F, w, fa.data(), n);
+    if (!square) {
+        fb.assign(n, 0);
+        for (size_t i = 0; i < nb; i++) fb[i] = F.to_mont(b[i]);
+        ntt_forward(F, w, fb.data(), n);
+    }
+    const Limbs& g = square ? fa : fb;
+    for (size_t i = 0; i < n; i++) fa[i] = F.mul(fa[i], g[i]);
+    ntt_inverse(F, w_inv, fa.data(), n);
+    // Divide by n and leave Montgomery form in one multiply: redc(x·n^-1·2^32)
+    uint32_t scale = F.pow(F.to_mont(uint32_t(n % F.P)), F.P - 2);
+    for (size_t i = 0; i < n; i++) fa[i] = F.redc(F.mul(fa[i], scale));
+    return fa;
+}
+
+// a·b from their digits in base 2^32 or, for the decimal conversion, 10^9
+Limbs mul_ntt(const uint32_t* a, size_t na, const uint32_t* b, size_t nb,
+              uint64_t base = uint64_t(1) << 32) {
+    static const NttPrime F1(998244353, 3), F2(167772161, 3), F3(469762049, 3);
+    size_t n = 1;
+    while (n < na + nb) n <<= 1;
+    Limbs r1 = ntt_convolve(F1, a, na, b, nb, n);
+    Limbs r2 = ntt_convolve(F2, a, na, b, nb, n);
+    Limbs r3 = ntt_convolve(F3, a, na, b, nb, n);
+
+    // Garner: x = v1 + p1·v2 + p1·p2·v3 with each v below its prime
+    const uint64_t p1 = F1.P, p2 = F2.P, p3 = F3.P;
+    auto inverse = [](uint64_t x, uint64_t p) {
+        uint64_t r = 1;
+        for (uint64_t e = p - 2; e > 0; e >>= 1, x = x * x % p)
+            if (e & 1) r = r * x % p;
+        return r;
+    };
+    const uint64_t inv_p1_mod_p2 = inverse(p1, p2);
+    const uint64_t inv_p1p2_mod_p3 = inverse(p1 * p2 % p3, p3);
+    const unsigned __int128 p1p2 = (unsigned __int128)p1 * p2;
+
+    Limbs r(na + nb, 0);
+    unsigned __int128 carry = 0;
+    for (size_t i = 0; i < na + nb; i++) {
+        uint64_t v1 = r1[i];
+        uint64_t v2 = (r2[i] + p2 - v1 % p2) % p2 * inv_p1_mod_p2 % p2;
+        uint64_t v3 = (r3[i] + p3 - (v1 + p1 * v2) % p3) % p3 * inv_p1p2_mod_p3 % p3;
+        carry += v1 + (unsigned __int128)p1 * v2 + p1p2 * v3;
+        if (base == (uint64_t(1) << 32)) {
+            r[i] = uint32_t(carry);
+            carry >>= 32;
+        } else {
+            r[i] = uint32_t(carry % base);
+            carry /= base;
+        }
+    }
+    return r;
+}
+
+// a·b as na + nb limbs (possibly with leading zeros)
+Limbs mul_limbs(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    if (na < nb) { std::swap(a, b); std::swap(na, nb); }
+    if (nb == 0) return Limbs(na, 0);
+    if (nb < kKaratsubaLimbs) return mul_schoolbook(a, na, b, nb);
+
+    if (nb <= na / 2) {
+        // Unbalanced: multiply b by pieces of a of its own length
+        Limbs r(na + nb, 0);
+        for (size_t i = 0; i < na; i += nb) {
+            size_t len = std::min(nb, na - i);
+            add_limbs_at(r, i, mul_limbs(a + i, len, b, nb));
+        }
+        return r;
+    }
+    if (nb >= kNttLimbs && nb <= kNttMaxOperand && na + nb <= kNttMaxLength) return mul_ntt(a, na, b, nb);
+    return mul_karatsuba(a, na, b, nb);
+}
+
+BigInt operator*(const BigInt& a, const BigInt& b) {
+    if (a.is_zero() || b.is_zero()) return BigInt();
+    return BigInt(mul_limbs(a.limbs.data(), a.limbs.size(), b.limbs.data(), b.limbs.size()));
+}
+
+// Decimal conversion
+//
+// Repeated division by 10^9 is quadratic in the length, so large values are
+// converted divide-and-conquer without any division: with x = hi·2^(32m) + lo
+// for m = 2^k limbs, both halves are converted recursively and combined as
+// dec(hi)·dec(2^(32m)) + dec(lo), multiplying directly in base 10^9 (the
+// same NTT, carrying in base 10^9). The powers dec(2^(32·2^k)) are built by
+// squaring and cached, so a conversion costs O(M(n) log n).
+//
+// For --digits, the leading digits come from an interval instead: x lies
+// between top·2^(32m) and (top + 1)·2^(32m), for its top few limbs, and
+// truncated base-10^9 powers bound 2^(32m) from below and above. When both ends
+// agree on the digit count and the requested leading digits, those are exact.
+// The trailing digits are x mod 10^t by Horner's rule.
+// ---------------------------------------------------------------------------
+const uint32_t kDecimalBase = 1000000000;
+const size_t kRadixSplitLimbs = 64;
+
+// Below this many base-10^9 chunks, decimal products are schoolbook
+const size_t kDecimalNttChunks = 400;
+
+// r[offset..] += x in base 10^9; r grows as needed
+void add_decimal_at(Limbs& r, size_t offset, const Limbs& x) {
+    if (r.size() < offset + x.size() + 1) r.resize(offset + x.size() + 1, 0);
+    uint32_t carry = 0;
+    size_t i = 0;
+    for (; i < x.size() || carry != 0; i++) {
+        uint32_t v = r[offset + i] + carry + (i < x.size() ? x[i] : 0);
+        carry = (v >= kDecimalBase);
+        r[offset + i] = carry ? v - kDecimalBase : v;
+        if (offset + i + 1 == r.size() && carry) r.push_back(0);
+    }
+    r.resize(offset + trimmed(r.data() + offset, r.size() - offset));
+}
+
+// a·b in base 10^9
+Limbs mul_decimal(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    if (na < nb) { std::swap(a, b); std::swap(na, nb); }
+    if (nb == 0) return Limbs();
+    if (nb < kDecimalNttChunks) {
+        Limbs r(na + nb, 0);
+        for (size_t i = 0; i < na; i++) {
+            uint64_t carry = 0, ai = a[i];
+            uint32_t* out = r.data() + i;
+            for (size_t j = 0; j < nb; j++) {
+                carry += ai * b[j] + out[j];
+                out[j] = uint32_t(carry % kDecimalBase);
+                carry /= kDecimalBase;
+            }
+            out[nb] = uint32_t(carry);
+        }
+        return r;
+    }
+    if (nb <= kNttMaxOperand && na + nb <= kNttMaxLength) return mul_ntt(a, na, b, nb, kDecimalBase);
+
+    // Too long for one transform: split the longer operand in half
+    size_t h = na / 2;
+    Limbs r = mul_decimal(a, h, b, nb);
+    add_decimal_at(r, h, mul_decimal(a + h, na - h, b, nb));
+    return r;
+}
+
+// dec(2^(32·2^k)), built on demand by squaring
+const Limbs& decimal_power_of_two(int k) {
+    static std::mutex lock;
+    static std::deque<Limbs> powers;
+    std::lock_guard<std::mutex> guard(lock);
+    if (powers.empty()) powers.push_back({294967296, 4});  // 2^32
+    while ((int)powers.size() <= k) {
+        const Limbs& p = powers.back();
+        Limbs sq = mul_decimal(p.data(), p.size(), p.data(), p.size());
+        sq.resize(trimmed(sq.data(), sq.size()));
+        powers.push_back(std::move(sq));
+    }
+    return powers[k];
+}
+
+// Base-10^9 chunks of the n limbs at a, least significant first
+Limbs binary_to_decimal(const uint32_t* a, size_t n) {
+    n = trimmed(a, n);
+    if (n <= kRadixSplitLimbs) {
+        Limbs q(a, a + n), chunks;
+        while (!q.empty()) {
+            uint64_t rem = 0;
+            for (size_t i = q.size(); i-- > 0;) {
+                uint64_t cur = (rem << 32) | q[i];
+                q[i] = uint32_t(cur / kDecimalBase);
+                rem = cur % kDecimalBase;
+            }
+            chunks.push_back(uint32_t(rem));
+            while (!q.empty() && q.back() == 0) q.pop_back();
+        }
+        return chunks;
+    }
+
+    int k = 0;
+    while ((size_t(2) << k) < n) k++;  // 2^k < n <= 2^(k+1)
+    size_t m = size_t(1) << k;
+    Limbs lo = binary_to_decimal(a, m);
+    Limbs hi = binary_to_decimal(a + m, n - m);
+    const Limbs& p = decimal_power_of_two(k);
+    Limbs r = mul_decimal(hi.data(), hi.size(), p.data(), p.size());
+    add_decimal_at(r, 0, lo);
+    return r;
+}
+
+std::string decimal_string(const Limbs& chunks) {
+    if (chunks.empty()) return "0";
+    std::string s;
+    s.reserve(chunks.size() * 9);
+    char tmp[10];
+    char* end = std::to_chars(tmp, tmp + sizeof(tmp), chunks.back()).ptr;
+    s.append(tmp, end);
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        end = std::to_chars(tmp, tmp + sizeof(tmp), chunks[i]).ptr;
+        s.append(9 - (end - tmp), '0');
+        s.append(tmp, end);
+    }
+    return s;
+}
+
+std::string BigInt::to_string() const {
+    return decimal_string(binary_to_decimal(limbs.data(), limbs.size()));
+}
+
+// A positive value known to `keep` base-10^9 chunks: chunks·10^(9·shift),
+// truncated (a lower bound) or rounded up (an upper bound)
+struct DecimalApprox {
+    Limbs chunks;
+    long long shift = 0;
+
+    void truncate(size_t keep, bool round_up) {
+        chunks.resize(trimmed(chunks.data(), chunks.size()));
+        if (chunks.size() <= keep) return;
+        size_t drop = chunks.size() - keep;
+        bool inexact = trimmed(chunks.data(), drop) != 0;
+        chunks.erase(chunks.begin(), chunks.begin() + drop);
+        shift += drop;
+        if (round_up && inexact) add_decimal_at(chunks, 0, Limbs{1});
+    }
+
+    static DecimalApprox product(const DecimalApprox& a, const DecimalApprox& b, size_t keep, bool round_up) {
+        DecimalApprox r;
+        r.chunks = mul_decimal(a.chunks.data(), a.chunks.size(), b.chunks.data(), b.chunks.size());
+        r.shift = a.shift + b.shift;
+        r.truncate(keep, round_up);
+        return r;
+    }
+};
+
+// Bounds on 2^(32m) by repeated squaring of 2^32
+DecimalApprox power_of_two_bound(size_t m, size_t keep, bool round_up) {
+    DecimalApprox r, base;
+    r.chunks = {1};
+    base.chunks = {294967296, 4};
+    for (; m > 0; m >>= 1) {
+        if (m & 1) r = DecimalApprox::product(r, base, keep, round_up);
+        if (m > 1) base = DecimalApprox::product(base, base, keep, round_up);
+    }
+    return r;
+}
+
+// The first `count` decimal digits of x and its digit count, or false when the
+// bounds straddle a digit boundary and only a full conversion can tell
+bool decimal_head(const BigInt& x, size_t count, std::string& head, long long& digits) {
+    const std::vector<uint32_t>& limbs = x.data();
+    size_t top = std::min(limbs.size(), count / 9 + 3);
+    size_t m = limbs.size() - top;
+    size_t keep = count / 9 + 4;
+
+    BigInt hi(std::vector<uint32_t>(limbs.end() - top, limbs.end()));
+    DecimalApprox lo, up;
+    lo.chunks = binary_to_decimal(hi.data().data(), hi.size());
+    BigInt hi1 = hi + BigInt(1);
+    up.chunks = binary_to_decimal(hi1.data().data(), hi1.size());
+    if (m > 0) {
+        lo = DecimalApprox::product(lo, power_of_two_bound(m, keep, false), keep, false);
+        up = DecimalApprox::product(up, power_of_two_bound(m, keep, true), keep, true);
+    }
+
+    // An exact conversion (m == 0) is its own lower bound
+    std::string s_lo = decimal_string(lo.chunks), s_up = decimal_string(up.chunks);
+    long long d_lo = (long long)s_lo.size() + 9 * lo.shift;
+    long long d_up = (long long)s_up.size() + 9 * up.shift;
+    if (m == 0) { d_up = d_lo; s_up = s_lo; }
+    if (d_lo != d_up || s_lo.size() < count || s_lo.compare(0, count, s_up, 0, count) != 0) return false;
+    head = s_lo.substr(0, count);
+    digits = d_lo;
+    return true;
+}
+
+// The last `count` decimal digits of x, zero-padded
+std::string decimal_tail(const BigInt& x, size_t count) {
+    size_t n = (count + 8) / 9;
+    uint32_t top_mod = 1;
+    for (size_t i = 0; i < count - 9 * (n - 1); i++) top_mod *= 10;
+
+    // r = x mod 10^count, in base 10^9, by r = r·2^32 + limb from the top
+    Limbs r(n, 0);
+    const std::vector<uint32_t>& limbs = x.data();
+    for (size_t i = limbs.size(); i-- > 0;) {
+        uint64_t carry = limbs[i];
+        for (size_t j = 0; j < n; j++) {
+            carry += (uint64_t(r[j]) << 32);
+            r[j] = uint32_t(carry % kDecimalBase);
+            carry /= kDecimalBase;
+        }
+        r[n - 1] %= top_mod;
+    }
+    std::string s = decimal_string(r);
+    return std::string(count > s.size() ? count - s.size() : 0, '0') + s;
+}
+
+// Modular integers
+//
+// Residues modulo an odd P < 2^63, held in Montgomery form x·2^64 mod P. A
+// product reduces with two 64-bit multiplies and a shift (REDC) instead of a
+// 128-bit division, and sums and differences need only a compare-and-correct,
+// so no counting step ever divides. The modulus is per thread and must be set
+// with ModInt::set_modulus before any values are created.
+// ---------------------------------------------------------------------------
+class ModInt {
+public:
+    // False if p is even, below 3, or too large for lazy addition
+    static bool valid_modulus(uint64_t p) { return p >= 3 && p % 2 == 1 && p < (uint64_t(1) << 63); }
+
+    // Returns false, leaving the modulus unchanged, unless valid_modulus(p)
+    static bool set_modulus(uint64_t p) {
+        if (!valid_modulus(p)) return false;
+        P = p;
+        // Newton's iteration for p^-1 mod 2^64; each step doubles the correct bits
+        uint64_t inv = p;
+        for (int i = 0; i < 5; i++) inv *= 2 - p * inv;
+        neg_inv = ~inv + 1;
+        uint64_t r = (~p + 1) % p;  // 2^64 mod p
+        R2 = uint64_t((unsigned __int128)r * r % p);
+        return true;
+    }
+    static uint64_t modulus() { return P; }
+
+    ModInt() : v(0) {}
+    ModInt(unsigned long long x) : v(redc((unsigned __int128)(x % P) * R2)) {}
+
+    uint64_t value() const { return redc(v); }
+
+    ModInt& operator+=(const ModInt& b) {
+        v += b.v;
+        if (v >= P) v -= P;
+        return *this;
+    }
+    ModInt& operator-=(const ModInt& b) {
+        v = (v >= b.v) ? v - b.v : v + P - b.v;
+        return *this;
+    }
+    ModInt& operator*=(const ModInt& b) {
+        v = redc((unsigned __int128)v * b.v);
+        return *this;
+    }
+
+    friend ModInt operator+(ModInt a, const ModInt& b) { return a += b; }
+    friend ModInt operator-(ModInt a, const ModInt& b) { return a -= b; }
+    friend ModInt operator*(ModInt a, const ModInt& b) { return a *= b; }
+    friend bool operator==(const ModInt& a, const ModInt& b) { return a.v == b.v; }
+    friend bool operator!=(const ModInt& a, const ModInt& b) { return a.v != b.v; }
+
+private:
+    uint64_t v;
+
+    static thread_local uint64_t P, neg_inv, R2;
+
+    // t·2^-64 mod P for t < P·2^64
+    static uint64_t redc(unsigned __int128 t) {
+        uint64_t m = uint64_t(t) * neg_inv;
+        uint64_t r = uint64_t((t + (unsigned __int128)m * P) >> 64);
+        return (r >= P) ? r - P : r;
+    }
+};
+
+thread_local uint64_t ModInt::P = 0, ModInt::neg_inv = 0, ModInt::R2 = 0;
+
+std::ostream& operator<<(std::ostream& os, const ModInt& v) { return os << v.value(); }
+
+// The largest N whose a_N fits in a long long; beyond it the CLI switches to
+// BigInt so every count is exact
+const long long kMaxLongLongN = 37;
 
 // Counting via the recurrence relation
 // a_N = 3*a_{N-1} + a_{N-2} - a_{N-3}, with a_0=1, a_1=2, a_2=7
-long long count_recurrence(int N) {
-    if (N < 0) return 0;
-    if (N == 0) return 1;
-    if (N == 1) return 2;
-    if (N == 2) return 7;
+//
+// All counting engines are templated on the number type T, which needs
+// construction from small integers, +, -, * and ==.
+
+// One recurrence step in place: a0 <- 3*a2 + a1 - a0
+template <typename T>
+inline void recurrence_step(T& a0, const T& a1, const T& a2) {
+    a0 = a2 + a2 + a2 + a1 - a0;
+}
+
+inline void recurrence_step(BigInt& a0, const BigInt& a1, const BigInt& a2) {
+    a0.recur(a1, a2);
+}
+
+template <typename T = long long>
+T count_recurrence(long long N) {
+    if (N < 0) return T(0);
+    if (N == 0) return T(1);
+    if (N == 1) return T(2);
+    if (N == 2) return T(7);
+
+    T a0(1), a1(2), a2(7);
+    for (long long i = 3; i <= N; i++) {
+        // Overwrite the oldest term and rotate; swaps move no limbs
+        recurrence_step(a0, a1, a2);
+        std::swap(a0, a1);
+        std::swap(a1, a2);
+    }
+    return a2;
+}
+
+// Exact a_N by the recurrence, specialised for BigInt
+//
+// The three live terms are kept as base-2^32 digits in signed 64-bit slots with
+// carries deferred. The recurrence is linear, so without carries each digit
+// position evolves independently: a run of k steps maps every digit triple
+// (x0, x1, x2) through the same 3×3 integer matrix J^k, and a carry pass
+// afterwards restores 32-bit digits. J^18 is the largest power whose row
+// sums of |coefficients| keep 32-bit digits below 2^63, so one pass of nine
+// multiplies per digit replaces eighteen full-length add/subtract passes.
+const int kRecurJump = 18;
+
+typedef std::array<std::array<int64_t, 3>, 3> Jump3;
+
+// Coefficients taking (a_i, a_{i+1}, a_{i+2}) to (a_{i+k}, a_{i+k+1}, a_{i+k+2})
+Jump3 recurrence_jump(int k) {
+    Jump3 J{};
+    for (int m = 0; m < 3; m++) {
+        std::array<int64_t, 3> v = {0, 0, 0};
+        v[m] = 1;
+        for (int s = 0; s < k; s++)
+            v = {v[1], v[2], 3 * v[2] + v[1] - v[0]};
+        for (int j = 0; j < 3; j++) J[j][m] = v[j];
+    }
+    return J;
+}
+
+template <>
+BigInt count_recurrence<BigInt>(long long N) {
+    if (N < 3) return BigInt((unsigned long long)count_recurrence<long long>(N));
+
+    // a_N < 3.22^(N+1), plus room for the deferred carries
+    size_t cap = size_t(double(N + 1) * 1.6871 / 32) + 4;
+    std::vector<int64_t> t0(cap, 0), t1(cap, 0), t2(cap, 0);
+    t0[0] = 1; t1[0] = 2; t2[0] = 7;
+    size_t len = 1;
+
+    const Jump3 full = recurrence_jump(kRecurJump);
+    for (long long remaining = N - 2; remaining > 0;) {
+        int steps = int(std::min<long long>(remaining, kRecurJump));
+        remaining -= steps;
+        const Jump3 J = (steps == kRecurJump) ? full : recurrence_jump(steps);
+
+        // Apply J digit by digit and propagate the three carries in the same
+        // pass. Terms are positive, so the final carries are never negative.
+        int64_t* p0 = t0.data();
+        int64_t* p1 = t1.data();
+        int64_t* p2 = t2.data();
+        int64_t c0 = 0, c1 = 0, c2 = 0;
+        for (size_t l = 0; l < len; l++) {
+            int64_t x0 = p0[l], x1 = p1[l], x2 = p2[l];
+            c0 += J[0][0] * x0 + J[0][1] * x1 + J[0][2] * x2;
+            c1 += J[1][0] * x0 + J[1][1] * x1 + J[1][2] * x2;
+            c2 += J[2][0] * x0 + J[2][1] * x1 + J[2][2] * x2;
+            p0[l] = c0 & 0xffffffff; c0 >>= 32;
+            p1[l] = c1 & 0xffffffff; c1 >>= 32;
+            p2[l] = c2 & 0xffffffff; c2 >>= 32;
+        }
+        for (; c0 > 0 || c1 > 0 || c2 > 0; len++) {
+            p0[len] = c0 & 0xffffffff; c0 >>= 32;
+            p1[len] = c1 & 0xffffffff; c1 >>= 32;
+            p2[len] = c2 & 0xffffffff; c2 >>= 32;
+        }
+    }
+    return BigInt(std::vector<uint32_t>(t2.begin(), t2.begin() + len));
+}
+
+// Sequence cache
+//
+// Exact terms a_0, a_1, ... computed so far, shared by every caller in the
+// process, so repeated and overlapping exact queries reuse them at O(1) per
+// term. The terms live in one array allocated up front and never move, and
+// the number published so far is an atomic written with release order after
+// the terms themselves. A term below that count is read with a single acquire
+// load and no lock; only growing takes the mutex, and it extends by
+// recurrence steps from the last three terms.
+//
+// The cache holds the first kSequenceCacheTerms terms, about 10 MB of limbs;
+// larger N go straight to the counting engines. `verify` and `count-batch`
+// grow it, while a single `count` only reads terms already there. With
+// --sequence-cache FILE the terms are read from FILE at startup, every exact
+// count in range goes through the cache, and it is written back at exit if
+// the process computed more terms.
+// ---------------------------------------------------------------------------
+const long long kSequenceCacheTerms = 10000;
+
+class SequenceCache {
+public:
+    SequenceCache() : terms(new BigInt[kSequenceCacheTerms]), count(3) {
+        terms[0] = 1;
+        terms[1] = 2;
+        terms[2] = 7;
+    }
+    ~SequenceCache() {
+        if (!path.empty() && size() > saved) save(path);
+    }
+
+    // a_n for 0 <= n < kSequenceCacheTerms; the reference stays valid
+    const BigInt& get(long long n) {
+        if (n >= count.load(std::memory_order_acquire)) extend(n + 1);
+        return terms[n];
+    }
+
+    long long size() const { return count.load(std::memory_order_acquire); }
+    bool persistent() const { return !path.empty(); }
+
+    // Load the terms saved in a cache file and save there again at exit
+    void attach(const std::string& file) {
+        std::lock_guard<std::mutex> guard(lock);
+        path = file;
+        load(file);
+        saved = count.load(std::memory_order_relaxed);
+    }
+
+private:
+    void extend(long long n) {
+        std::lock_guard<std::mutex> guard(lock);
+        long long have = count.load(std::memory_order_relaxed);
+        for (long long i = have; i < n; i++) {
+            terms[i] = terms[i - 3];
+            recurrence_step(terms[i], terms[i - 2], terms[i - 1]);
+        }
+        if (n > have) count.store(n, std::memory_order_release);
+    }
+
+    // On-disk form: "SEQ1", the term count, then per term a limb count and
+    // the limbs, all uint32 in host byte order. A file whose first terms or
+    // any recurrence step do not check out is ignored; checking every step
+    // costs n additions, a fraction of the time to read the file.
+    void load(const std::string& file) {
+        std::ifstream in(file, std::ios::binary);
+        char magic[4];
+        uint32_t n = 0;
+        in.read(magic, 4);
+        in.read(reinterpret_cast<char*>(&n), 4);
+        if (!in || std::memcmp(magic, "SEQ1", 4) != 0 || n < 3 || n > kSequenceCacheTerms) return;
+
+        std::vector<BigInt> read(n);
+        for (uint32_t i = 0; i < n && in; i++) {
+            uint32_t limbs = 0;
+            in.read(reinterpret_cast<char*>(&limbs), 4);
+            if (!in || limbs > (i + 1) / 18 + 1) return;  // a_i < 2^(1.69(i+1))
+            std::vector<uint32_t> l(limbs);
+            in.read(reinterpret_cast<char*>(l.data()), std::streamsize(limbs) * 4);
+            read[i] = BigInt(std::move(l));
+        }
+        if (!in || read[0] != BigInt(1) || read[1] != BigInt(2) || read[2] != BigInt(7)) return;
+        BigInt check;
+        for (uint32_t i = 3; i < n; i++) {
+            check = read[i - 3];
+            recurrence_step(check, read[i - 2], read[i - 1]);
+            if (check != read[i]) return;
+        }
+
+        long long have = count.load(std::memory_order_relaxed);
+        for (long long i = have; i < (long long)n; i++) terms[i] = std::move(read[i]);
+        if (n > have) count.store(n, std::memory_order_release);
+    }
+
+    void save(const std::string& file) const {
+        // Written under a temporary name first, as save_transfer_matrix
+        std::string tmp = file + ".tmp" + std::to_string(::getpid());
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            uint32_t n = uint32_t(size());
+            out.write("SEQ1", 4);
+            out.write(reinterpret_cast<const char*>(&n), 4);
+            for (uint32_t i = 0; i < n; i++) {
+                uint32_t limbs = uint32_t(terms[i].size());
+                out.write(reinterpret_cast<const char*>(&limbs), 4);
+                out.write(reinterpret_cast<const char*>(terms[i].data().data()), std::streamsize(limbs) * 4);
+            }
+            if (!out) { std::remove(tmp.c_str()); return; }
+        }
+        std::rename(tmp.c_str(), file.c_str());
+    }
+
+    std::unique_ptr<BigInt[]> terms;
+    std::atomic<long long> count;
+    std::mutex lock;
+    std::string path;
+    long long saved = 0;
+};
+
+// The process-wide cache
+SequenceCache& sequence_cache() {
+    static SequenceCache cache;
+    return cache;
+}
+
+// Reusable DP layers
+//
+// Every column engine keeps two layers of counts and swaps them after each
+// step. The layers come from a per-thread pool, one per count type, that only
+// ever grows: a call takes the first S slots of both buffers, zeroes them and
+// ping-pongs between them by pointer. Zeroing a BigInt keeps its limb
+// storage, so once a thread has counted a floor of some size, counting it
+// again (or a smaller one) allocates nothing inside the engine. The pool is
+// not reentrant, which holds because no engine calls another of the same
+// count type while it holds the layers.
+// ---------------------------------------------------------------------------
+template <typename T>
+struct DpLayers {
+    T* cur;
+    T* nxt;
+    void swap() { std::swap(cur, nxt); }
+};
+
+template <typename T>
+DpLayers<T> dp_layers(size_t S) {
+    thread_local std::vector<T> a, b;
+    if (a.size() < S) {
+        a.resize(S);
+        b.resize(S);
+    }
+    std::fill(a.begin(), a.begin() + S, T(0));
+    std::fill(b.begin(), b.begin() + S, T(0));
+    return DpLayers<T>{a.data(), b.data()};
+}
+
+// Counting via bitmask DP
+//
+// Process the grid column by column - "profile" is a bitmask of 2 bits
+// representing which cells in the current column are already filled by tiles
+// extending from the previous column.
+//
+// At each column, we try all ways to fill the empty cells using:
+//   - 1×1 tiles (fill one cell)
+//   - Vertical 2×1 tiles (fill both cells in this column)
+//   - Horizontal 2×1 tiles (extend into the next column, setting bits in the
+//     next profile)
+//
+// Profile bits: bit 0 = top row, bit 1 = bottom row.
+// ---------------------------------------------------------------------------
+// One column: ndp from dp, where `last` forbids horizontal tiles leaving the floor
+template <typename T>
+void dp_column(const T* dp, T* ndp, bool last) {
+    std::fill(ndp, ndp + 4, T(0));
+    for (int mask = 0; mask < 4; mask++) {
+        if (dp[mask] == T(0)) continue;
+
+        bool top_filled = (mask >> 0) & 1;
+        bool bot_filled = (mask >> 1) & 1;
+        STAT_ADD(dp_transitions, 1);
+
+        if (top_filled && bot_filled) {
+            // Both cells pre-filled; nothing to place, next profile = 0
+            ndp[0] += dp[mask];
+        } else if (top_filled && !bot_filled) {
+            // Only bottom cell is empty
+            // Option 1: place 1×1 in bottom
+            ndp[0] += dp[mask];
+            // Option 2: place horizontal 2×1 in bottom (extends right)
+            if (!last)
+                ndp[2] += dp[mask]; // bit 1 set in next column
+        } else if (!top_filled && bot_filled) {
+            // Only top cell is empty
+            // Option 1: place 1×1 in top
+            ndp[0] += dp[mask];
+            // Option 2: place horizontal 2×1 in top (extends right)
+            if (!last)
+                ndp[1] += dp[mask]; // bit 0 set in next column
+        } else {
+            // Both cells empty
+            // Option 1: vertical 2×1 covering both
+            ndp[0] += dp[mask];
+            // Option 2: two 1×1 tiles
+            ndp[0] += dp[mask];
+            // Option 3: 1×1 top + horizontal bottom
+            if (!last)
+                ndp[2] += dp[mask];
+            // Option 4: horizontal top + 1×1 bottom
+            if (!last)
+                ndp[1] += dp[mask];
+            // Option 5: horizontal top + horizontal bottom
+            if (!last)
+                ndp[3] += dp[mask];
+        }
+    }
+}
+
+template <typename T = long long>
+T count_dp(long long N) {
+    if (N == 0) return T(1);
+    PhaseTimer timer(kPhaseDp);
+
+    // dp[profile] = number of ways to fill columns 0..col-1 s.t.
+    // column col has the given profile of pre-filled cells.
+    DpLayers<T> dp = dp_layers<T>(4);
+    dp.cur[0] = T(1); // column 0 starts empty
+
+    for (long long col = 0; col < N; col++) {
+        dp_column(dp.cur, dp.nxt, col + 1 == N);
+        dp.swap();
+    }
+
+    return dp.cur[0];
+}
+
+// a_0..a_N from one DP pass: after c columns, the profile with nothing
+// overhanging counts exactly the tilings of a 2×c floor
+template <typename T = long long>
+std::vector<T> count_dp_prefixes(long long N) {
+    PhaseTimer timer(kPhaseDp);
+    std::vector<T> counts(1, T(1));
+    counts.reserve(size_t(N) + 1);
+    DpLayers<T> dp = dp_layers<T>(4);
+    dp.cur[0] = T(1);
+    for (long long col = 0; col < N; col++) {
+        dp_column(dp.cur, dp.nxt, false);
+        dp.swap();
+        counts.push_back(dp.cur[0]);
+    }
+    return counts;
+}
+
+// Tile composition
+//
+// The same column DP with each profile's count replaced by a polynomial in a
+// marker y: the coefficient of y^k counts the partial tilings that use k 1×1
+// tiles. Placing a 1×1 tile multiplies by y and a 2×1 tile by 1, so the final
+// polynomial of the empty profile is the composition distribution, with
+// coefficients summing to a_N. A tiling with k 1×1 tiles has (2N − k)/2
+// dominoes. After c columns the degree is at most 2c, so the pass costs
+// O(N²) coefficient additions.
+//
+// In one column, coefficient j of each new polynomial reads only
+// coefficients j, j−1 and j−2 of the old ones. The update therefore splits
+// into coefficient ranges that workers fill independently, meeting at a
+// barrier after every column. Short floors run on the calling thread, since
+// a barrier costs more than a column of small additions.
+// ---------------------------------------------------------------------------
+const int kCompositionParallelN = 512;
+
+// Reusable barrier for a fixed number of threads
+class ColumnBarrier {
+public:
+    explicit ColumnBarrier(int n) : count(n) {}
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        uint64_t gen = generation;
+        if (++arrived == count) {
+            arrived = 0;
+            generation++;
+            released.notify_all();
+            return;
+        }
+        released.wait(lock, [&] { return generation != gen; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable released;
+    int count, arrived = 0;
+    uint64_t generation = 0;
+};
+
+// Coefficients lo..hi-1 of the profile polynomials after one more column
+template <typename T>
+void composition_column(const std::vector<T>* dp, std::vector<T>* ndp, size_t lo, size_t hi, bool last) {
+    for (size_t j = lo; j < hi; j++) {
+        // Profile 0: a vertical tile, two 1×1 tiles, or the one free cell of
+        // profile 1 or 2 taking a 1×1 tile; profile 3 passes through
+        T& n0 = ndp[0][j];
+        n0 = dp[3][j];
+        n0 += dp[0][j];
+        if (j >= 1) {
+            n0 += dp[1][j - 1];
+            n0 += dp[2][j - 1];
+        }
+        if (j >= 2) n0 += dp[0][j - 2];
+        if (last) {
+            ndp[1][j] = T(0);
+            ndp[2][j] = T(0);
+            ndp[3][j] = T(0);
+            continue;
+        }
+        // Horizontal tiles into the next column, beside a 1×1 when the
+        // other cell was free
+        ndp[1][j] = dp[2][j];
+        ndp[2][j] = dp[1][j];
+        if (j >= 1) {
+            ndp[1][j] += dp[0][j - 1];
+            ndp[2][j] += dp[0][j - 1];
+        }
+        ndp[3][j] = dp[0][j];
+    }
+    STAT_ADD(dp_transitions, hi - lo);
+}
+
+// c[k] = number of tilings of a 2×N floor with exactly k 1×1 tiles, k = 0..2N
+template <typename T>
+std::vector<T> composition_counts(int N, int threads) {
+    if (N == 0) return std::vector<T>(1, T(1));
+    PhaseTimer timer(kPhaseDp);
+    const size_t D = 2 * size_t(N) + 1;
+    std::vector<T> layer[2][4];
+    for (auto& l : layer)
+        for (auto& p : l) p.assign(D, T(0));
+    layer[0][0][0] = T(1);
+
+    if (N < kCompositionParallelN) threads = 1;
+    threads = std::max(threads, 1);
+    ColumnBarrier barrier(threads);
+    auto worker = [&](int t) {
+        for (int col = 0; col < N; col++) {
+            size_t end = std::min(D, 2 * size_t(col) + 3);  // degrees 0..2col+2
+            size_t lo = end * size_t(t) / size_t(threads), hi = end * size_t(t + 1) / size_t(threads);
+            composition_column(layer[col & 1], layer[(col + 1) & 1], lo, hi, col + 1 == N);
+            if (threads > 1) barrier.wait();
+        }
+        if (t > 0) stats_flush();
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker, t);
+    worker(0);
+    for (std::thread& t : pool) t.join();
+    return std::move(layer[N & 1][0]);
+}
+
+// Compile-time table of small counts
+//
+// Every a_N up to kMaxLongLongN fits in a long long, so that whole range is
+// computed by the compiler and `count`, `count-batch` and `table` answer it
+// by lookup: no loop and no allocation. A column DP over a plain array, with
+// the same transitions as dp_column, is also run at compile time, and the
+// two independent derivations must agree for every entry.
+// ---------------------------------------------------------------------------
+constexpr std::array<long long, kMaxLongLongN + 1> small_counts_by_recurrence() {
+    std::array<long long, kMaxLongLongN + 1> a{};
+    a[0] = 1;
+    a[1] = 2;
+    a[2] = 7;
+    for (int i = 3; i <= kMaxLongLongN; i++) a[i] = 3 * a[i - 1] + a[i - 2] - a[i - 3];
+    return a;
+}
+
+constexpr std::array<long long, kMaxLongLongN + 1> kSmallCounts = small_counts_by_recurrence();
+
+// count_dp<long long>(N) in a form the compiler can evaluate
+constexpr long long small_count_by_dp(int N) {
+    if (N == 0) return 1;
+    long long dp[4] = {1, 0, 0, 0};
+    for (int col = 0; col < N; col++) {
+        bool last = (col + 1 == N);
+        long long ndp[4] = {0, 0, 0, 0};
+        ndp[0] = dp[3] + dp[1] + dp[2] + 2 * dp[0];  // both pre-filled; one cell free; vertical or two 1×1
+        if (!last) {
+            ndp[2] = dp[1] + dp[0];  // horizontal leaving the bottom
+            ndp[1] = dp[2] + dp[0];  // horizontal leaving the top
+            ndp[3] = dp[0];          // both horizontal
+        }
+        for (int m = 0; m < 4; m++) dp[m] = ndp[m];
+    }
+    return dp[0];
+}
+
+constexpr bool small_counts_match_dp() {
+    for (int N = 0; N <= kMaxLongLongN; N++)
+        if (small_count_by_dp(N) != kSmallCounts[N]) return false;
+    return true;
+}
+
+static_assert(small_counts_match_dp(), "recurrence and DP disagree on a_0..a_kMaxLongLongN");
+static_assert(kSmallCounts[10] == 78243, "the LEGO floor has 78243 tilings");
+
+// Counting via matrix exponentiation
+//
+// The transitions in count_dp are the same for every column, so N columns are
+// the N-th power of one transition matrix. Profiles 1 and 2 are mirror images,
+// and folding them into a single "one cell pre-filled" state leaves a 3×3
+// matrix (rows = from, columns = to, states 0 / one filled / both filled):
+//
+//   [ 2  2  1 ]
+//   [ 1  1  0 ]
+//   [ 1  0  0 ]
+//
+// Its characteristic polynomial is x³ − 3x² − x + 1, matching the recurrence,
+// and a_N is the (0,0) entry of M^N. Repeated squaring needs O(log N) products.
+// ---------------------------------------------------------------------------
+template <typename T>
+using Mat3 = std::array<std::array<T, 3>, 3>;
+
+template <typename T>
+Mat3<T> mat3_mul(const Mat3<T>& A, const Mat3<T>& B) {
+    Mat3<T> C;
+    for (auto& row : C) row.fill(T(0));
+    for (int i = 0; i < 3; i++)
+        for (int k = 0; k < 3; k++)
+            for (int j = 0; j < 3; j++)
+                C[i][j] += A[i][k] * B[k][j];
+    return C;
+}
+
+template <typename T = long long>
+T count_matpow(long long N) {
+    if (N < 0) return T(0);
+
+    Mat3<T> base = {{{T(2), T(2), T(1)}, {T(1), T(1), T(0)}, {T(1), T(0), T(0)}}};
+
+    // Only row 0 of M^N is needed, so carry a row vector instead of a full
+    // result matrix; powers of M commute, so the order of products is free.
+    std::array<T, 3> v = {T(1), T(0), T(0)};
+    while (N > 0) {
+        if (N & 1) {
+            std::array<T, 3> nv = {T(0), T(0), T(0)};
+            for (int k = 0; k < 3; k++)
+                for (int j = 0; j < 3; j++)
+                    nv[j] += v[k] * base[k][j];
+            v = nv;
+        }
+        N >>= 1;
+        if (N > 0) base = mat3_mul(base, base);
+    }
+
+    return v[0];
+}
+
+// Above this N, `count` switches from the O(N) DP to an O(log N) jump (Kitamasa,
+// below) for fixed-width number types.
+const long long kMatpowThreshold = 64;
+
+// Above this N, exact counts also switch from the recurrence to Kitamasa. The
+// recurrence is O(N²) in bit operations; the jumps cost a few products of the
+// final size, which the NTT makes O(N log N), but below this the recurrence's
+// small constant wins.
+const long long kKitamasaExactThreshold = 20000;
+
+// Counting via Kitamasa's method
+//
+// Powers of the count_matpow matrix commute with it, so only x^N modulo the
+// characteristic polynomial x³ − 3x² − x + 1 is needed: three coefficients
+// (c0, c1, c2) with a_N = c0·a_0 + c1·a_1 + c2·a_2, and the same coefficients
+// give a_{N+j} = c0·a_j + c1·a_{j+1} + c2·a_{j+2}. A product of two such
+// polynomials takes 9 multiplies (6 for a square) and folds back in with
+// x³ = 3x² + x − 1 and x⁴ = 10x² + 2x − 3, against 27 per 3×3 matrix product.
+// The jump also yields the next two terms, so a range a_A..a_B costs one
+// O(log A) jump and then B − A recurrence steps.
+//
+// The coefficients can be negative. long long work is done in unsigned
+// arithmetic, exact modulo 2^64 and so exact for every a_N that fits, and
+// BigInt work in SignedBig.
+// ---------------------------------------------------------------------------
+struct SignedBig {
+    BigInt mag;
+    bool neg = false;
+
+    SignedBig() {}
+    SignedBig(unsigned long long v) : mag(v) {}
+    SignedBig(BigInt m, bool n) : mag(std::move(m)), neg(n && !mag.is_zero()) {}
+
+    friend SignedBig operator+(const SignedBig& a, const SignedBig& b) {
+        if (a.neg == b.neg) return SignedBig(a.mag + b.mag, a.neg);
+        if (a.mag < b.mag) return SignedBig(b.mag - a.mag, b.neg);
+        return SignedBig(a.mag - b.mag, a.neg);
+    }
+    friend SignedBig operator-(const SignedBig& a, const SignedBig& b) {
+        return a + SignedBig(b.mag, !b.neg);
+    }
+    friend SignedBig operator*(const SignedBig& a, const SignedBig& b) {
+        return SignedBig(a.mag * b.mag, a.neg != b.neg);
+    }
+};
+
+// Type the coefficients are computed in, and the way back to T
+template <typename T> struct KitamasaWork { typedef T type; };
+template <> struct KitamasaWork<long long> { typedef unsigned long long type; };
+template <> struct KitamasaWork<BigInt> { typedef SignedBig type; };
+
+template <typename T> T from_kitamasa_work(const T& v) { return v; }
+inline long long from_kitamasa_work(unsigned long long v) { return (long long)v; }
+inline BigInt from_kitamasa_work(const SignedBig& v) { return v.mag; }  // a_N >= 0
+
+template <typename T>
+using Poly3 = std::array<T, 3>;
+
+// Fold d0 + d1·x + d2·x² + d3·x³ + d4·x⁴ back to degree 2. The small
+// multiples are sums, which are cheaper than multiplies in every number type.
+template <typename T>
+Poly3<T> poly3_reduce(const T& d0, const T& d1, const T& d2, const T& d3, const T& d4) {
+    T d4x2 = d4 + d4;
+    T d4x3 = d4x2 + d4;
+    T d4x10 = d4x3 + d4x3 + d4x3 + d4;
+    return {d0 - d3 - d4x3, d1 + d3 + d4x2, d2 + d3 + d3 + d3 + d4x10};
+}
+
+// p·q mod x³ − 3x² − x + 1
+template <typename T>
+Poly3<T> poly3_mulmod(const Poly3<T>& p, const Poly3<T>& q) {
+    return poly3_reduce(p[0] * q[0],
+                        p[0] * q[1] + p[1] * q[0],
+                        p[0] * q[2] + p[1] * q[1] + p[2] * q[0],
+                        p[1] * q[2] + p[2] * q[1],
+                        p[2] * q[2]);
+}
+
+template <typename T>
+Poly3<T> poly3_square(const Poly3<T>& p) {
+    T p01 = p[0] * p[1], p02 = p[0] * p[2], p12 = p[1] * p[2];
+    return poly3_reduce(p[0] * p[0], p01 + p01, p02 + p02 + p[1] * p[1], p12 + p12, p[2] * p[2]);
+}
+
+// a_N, a_{N+1}, a_{N+2} from one jump to x^N
+template <typename T>
+std::array<T, 3> kitamasa_terms(long long N) {
+    typedef typename KitamasaWork<T>::type W;
+    Poly3<W> c = {W(1), W(0), W(0)}, b = {W(0), W(1), W(0)};
+    for (; N > 0; N >>= 1) {
+        if (N & 1) c = poly3_mulmod(c, b);
+        if (N > 1) b = poly3_square(b);
+    }
+    const W a[5] = {W(1), W(2), W(7), W(22), W(71)};
+    std::array<T, 3> terms;
+    for (int j = 0; j < 3; j++)
+        terms[j] = from_kitamasa_work(c[0] * a[j] + c[1] * a[j + 1] + c[2] * a[j + 2]);
+    return terms;
+}
+
+template <typename T = long long>
+T count_kitamasa(long long N) {
+    if (N < 0) return T(0);
+    return kitamasa_terms<T>(N)[0];
+}
+
+// High-precision closed form
+//
+// G(x) = (1 − x) / f(x) with f(x) = x³ − x² − 3x + 1 has simple poles at the
+// three real roots r_i of f, so a_N = Σ A_i / r_i^(N+1) with
+// A_i = (r_i − 1) / f'(r_i). `closedform` evaluates this sum in a binary
+// floating point of any precision: sign · mant · 2^(32·exp), with the
+// magnitude cut to a fixed number of limbs after every operation.
+//
+// The roots start from double estimates and are refined by Newton's method,
+// and reciprocals by the iteration y ← y + y(1 − dy). Both double their
+// accurate digits per step, so each step runs at about twice the precision of
+// the one before and only the last is at full width. The reciprocals 1/r_i are
+// then raised to the N+1-th power by repeated squaring. Every rounding error
+// in a power is amplified at most N+1 times, so the working precision carries
+// 2·log2(N+2) + 64 guard bits above the requested digits.
+// ---------------------------------------------------------------------------
+struct BigFloat {
+    BigInt mant;
+    long long exp = 0;  // in limbs
+    bool neg = false;
+
+    bool is_zero() const { return mant.is_zero(); }
+    long long top() const { return exp + (long long)mant.size(); }  // one above the leading limb
+};
+
+// sign·mant·2^(32·exp), keeping the leading `limbs` limbs of mant
+BigFloat bf_make(BigInt mant, long long exp, bool neg, size_t limbs) {
+    BigFloat r;
+    const std::vector<uint32_t>& d = mant.data();
+    if (d.size() > limbs) {
+        size_t drop = d.size() - limbs;
+        r.mant = BigInt(std::vector<uint32_t>(d.begin() + drop, d.end()));
+        r.exp = exp + (long long)drop;
+    } else {
+        r.mant = std::move(mant);
+        r.exp = exp;
+    }
+    r.neg = neg && !r.mant.is_zero();
+    return r;
+}
+
+BigFloat bf_int(long long v) {
+    return bf_make(BigInt((unsigned long long)(v < 0 ? -v : v)), 0, v < 0, 2);
+}
+
+// x = t·2^(32e) with t the leading two limbs as a double in [1, 2^64)
+double bf_leading(const BigFloat& x, long long& e) {
+    const std::vector<uint32_t>& d = x.mant.data();
+    size_t n = d.size();
+    e = x.exp + (long long)n - std::min<long long>(n, 2);
+    return (n >= 2) ? std::ldexp(double(d[n - 1]), 32) + d[n - 2] : double(d[0]);
+}
+
+// v·2^(32e) for a finite nonzero double v
+BigFloat bf_from_double(double v, long long e) {
+    int bits;
+    double m = std::frexp(std::fabs(v), &bits);  // |v| = m·2^bits, m in [0.5, 1)
+    long long shift = bits - 64;
+    long long limb_shift = (shift >= 0) ? shift / 32 : -((31 - shift) / 32);
+    BigInt mant((unsigned long long)std::ldexp(m, 64));
+    mant *= uint32_t(1) << (shift - 32 * limb_shift);
+    return bf_make(std::move(mant), limb_shift + e, v < 0, 3);
+}
+
+BigFloat bf_mul(const BigFloat& a, const BigFloat& b, size_t limbs) {
+    if (a.is_zero() || b.is_zero()) return BigFloat();
+    size_t na = std::min(a.mant.size(), limbs), nb = std::min(b.mant.size(), limbs);
+    size_t da = a.mant.size() - na, db = b.mant.size() - nb;
+    BigInt p(mul_limbs(a.mant.data().data() + da, na, b.mant.data().data() + db, nb));
+    return bf_make(std::move(p), a.exp + b.exp + (long long)(da + db), a.neg != b.neg, limbs);
+}
+
+// The limbs of x at or above `lo`, as a multiple of 2^(32·lo)
+BigInt bf_aligned(const BigFloat& x, long long lo) {
+    const std::vector<uint32_t>& d = x.mant.data();
+    if (x.top() <= lo) return BigInt();
+    std::vector<uint32_t> out;
+    if (x.exp >= lo) {
+        out.assign(size_t(x.exp - lo), 0);
+        out.insert(out.end(), d.begin(), d.end());
+    } else {
+        out.assign(d.begin() + (lo - x.exp), d.end());
+    }
+    return BigInt(std::move(out));
+}
+
+// a + b; limbs of either operand more than `limbs` below the larger one are dropped
+BigFloat bf_add(const BigFloat& a, const BigFloat& b, size_t limbs) {
+    if (a.is_zero()) return bf_make(b.mant, b.exp, b.neg, limbs);
+    if (b.is_zero()) return bf_make(a.mant, a.exp, a.neg, limbs);
+    long long lo = std::max(std::min(a.exp, b.exp), std::max(a.top(), b.top()) - (long long)limbs - 1);
+    SignedBig s = SignedBig(bf_aligned(a, lo), a.neg) + SignedBig(bf_aligned(b, lo), b.neg);
+    return bf_make(std::move(s.mag), lo, s.neg, limbs);
+}
+
+BigFloat bf_sub(const BigFloat& a, BigFloat b, size_t limbs) {
+    b.neg = !b.neg && !b.is_zero();
+    return bf_add(a, b, limbs);
+}
+
+// Working precisions for a Newton iteration that starts from a double: each
+// about half the next, ending at `limbs`
+std::vector<size_t> newton_precisions(size_t limbs) {
+    std::vector<size_t> p;
+    for (size_t w = limbs; w > 2; w = w / 2 + 1) p.push_back(w);
+    p.push_back(2);
+    std::reverse(p.begin(), p.end());
+    return p;
+}
+
+// 1/d for nonzero d
+BigFloat bf_reciprocal(const BigFloat& d, size_t limbs) {
+    long long e;
+    double t = bf_leading(d, e);
+    BigFloat y = bf_from_double(d.neg ? -1 / t : 1 / t, -e);
+    BigFloat one = bf_int(1);
+    for (size_t p : newton_precisions(limbs)) {
+        BigFloat err = bf_sub(one, bf_mul(d, y, p + 1), p + 1);
+        y = bf_add(y, bf_mul(y, err, p), p);
+    }
+    return y;
+}
+
+BigFloat bf_pow(const BigFloat& x, unsigned long long n, size_t limbs) {
+    BigFloat r = bf_int(1);
+    for (int bit = 63; bit >= 0; bit--) {
+        r = bf_mul(r, r, limbs);
+        if ((n >> bit) & 1) r = bf_mul(r, x, limbs);
+    }
+    return r;
+}
+
+// f(x) and f'(x) for f(x) = x³ − x² − 3x + 1
+BigFloat closed_form_f(const BigFloat& x, size_t limbs) {
+    BigFloat v = bf_add(x, bf_int(-1), limbs);
+    v = bf_add(bf_mul(v, x, limbs), bf_int(-3), limbs);
+    return bf_add(bf_mul(v, x, limbs), bf_int(1), limbs);
+}
+
+BigFloat closed_form_df(const BigFloat& x, size_t limbs) {
+    BigFloat v = bf_add(bf_mul(bf_int(3), x, limbs), bf_int(-2), limbs);
+    return bf_add(bf_mul(v, x, limbs), bf_int(-3), limbs);
+}
+
+// The roots of f in increasing order, to `limbs` limbs
+std::array<BigFloat, 3> closed_form_roots(size_t limbs) {
+    std::array<BigFloat, 3> roots;
+    const double seeds[3] = {-1.5, 0.3, 2.2};
+    for (int i = 0; i < 3; i++) {
+        double x = seeds[i];
+        for (int k = 0; k < 6; k++) x -= (((x - 1) * x - 3) * x + 1) / ((3 * x - 2) * x - 3);
+        BigFloat r = bf_from_double(x, 0);
+        for (size_t p : newton_precisions(limbs)) {
+            BigFloat step = bf_mul(closed_form_f(r, p + 1), bf_reciprocal(closed_form_df(r, p), p), p);
+            r = bf_sub(r, step, p);
+        }
+        roots[i] = r;
+    }
+    return roots;
+}
+
+// Limbs holding `digits` significant decimal digits plus the guard bits for
+// an (N+1)-th power
+size_t closed_form_limbs(size_t digits, long long N) {
+    double bits = digits * 3.3219280948873623 + 2 * std::log2(double(N) + 2) + 64;
+    return size_t(bits / 32) + 2;
+}
+
+struct ClosedForm {
+    std::array<BigFloat, 3> roots, coeffs;
+    BigFloat sum;
+};
+
+// Σ A_i / r_i^(N+1) and its ingredients, to `limbs` limbs
+ClosedForm closed_form(long long N, size_t limbs) {
+    ClosedForm cf;
+    cf.roots = closed_form_roots(limbs);
+    for (int i = 0; i < 3; i++) {
+        const BigFloat& r = cf.roots[i];
+        cf.coeffs[i] = bf_mul(bf_add(r, bf_int(-1), limbs), bf_reciprocal(closed_form_df(r, limbs), limbs), limbs);
+        BigFloat power = bf_pow(bf_reciprocal(r, limbs), (unsigned long long)N + 1, limbs);
+        cf.sum = bf_add(cf.sum, bf_mul(cf.coeffs[i], power, limbs), limbs);
+    }
+    return cf;
+}
+
+// |x| rounded to the nearest integer
+BigInt bf_round_abs(const BigFloat& x) {
+    if (x.exp >= 0) return bf_aligned(x, 0);
+    BigInt q = bf_aligned(x, 0);
+    const std::vector<uint32_t>& d = x.mant.data();
+    size_t below = size_t(-x.exp) - 1;  // limb holding the first bit after the point
+    if (below < d.size() && (d[below] >> 31)) q += BigInt(1);
+    return q;
+}
+
+// |x| rounded to `digits` significant decimal digits, as a digit string s with
+// |x| ≈ s·10^scale; "0" for zero
+std::string bf_decimal_digits(const BigFloat& x, size_t digits, size_t limbs, long long& scale) {
+    scale = 0;
+    if (x.is_zero()) return "0";
+    long long e;
+    double t = bf_leading(x, e);
+    scale = (long long)std::floor(std::log10(t) + 32 * e * 0.30102999566398120) + 1 - (long long)digits;
+    for (;;) {
+        BigFloat ten = bf_int(10);
+        BigFloat scaled = (scale >= 0) ? bf_mul(x, bf_reciprocal(bf_pow(ten, scale, limbs), limbs), limbs)
+                                       : bf_mul(x, bf_pow(ten, -scale, limbs), limbs);
+        std::string s = bf_round_abs(scaled).to_string();
+        if (s.size() == digits) return s;
+        scale += (long long)s.size() - (long long)digits;  // the double estimate was off
+    }
+}
+
+// The digits s·10^scale written out: positional while they reach the units
+// place, otherwise (or when `scientific`) as d.ddd…e±X
+std::string decimal_notation(const std::string& s, long long scale, bool neg, bool scientific = false) {
+    if (s == "0") return s;
+    std::string sign = neg ? "-" : "";
+    if (scale > 0 || scientific) {
+        long long e10 = scale + (long long)s.size() - 1;
+        std::string frac = s.substr(1);
+        return sign + s[0] + (frac.empty() ? "" : "." + frac) + "e" + (e10 < 0 ? "-" : "+") +
+               std::to_string(e10 < 0 ? -e10 : e10);
+    }
+    size_t frac = size_t(-scale);
+    if (frac == 0) return sign + s;
+    if (s.size() <= frac) return sign + "0." + std::string(frac - s.size(), '0') + s;
+    return sign + s.substr(0, s.size() - frac) + "." + s.substr(s.size() - frac);
+}
+
+// x to `digits` significant digits
+std::string bf_to_string(const BigFloat& x, size_t digits, size_t limbs, bool scientific = false) {
+    long long scale;
+    std::string s = bf_decimal_digits(x, digits, limbs, scale);
+    return decimal_notation(s, scale, x.neg, scientific);
+}
+
+// Batch counting in SIMD lanes
+//
+// A batch of `count --mod` queries is evaluated kLanes queries at a time, one
+// query per lane, each with its own N and modulus. Powers of the count_matpow
+// matrix commute with it, so it is enough to carry x^N modulo its
+// characteristic polynomial x³ − 3x² − x + 1, three coefficients instead of a
+// 3×3 matrix, and a_N = c0·a_0 + c1·a_1 + c2·a_2. Every lane squares on every
+// step and keeps its product only where its own bit of N is set (a select,
+// not a branch), so all lanes follow the same instruction stream. Queries are
+// sorted by N so lanes of a group need about the same number of steps.
+//
+// Lanes use 32-bit Montgomery residues, x·2^32 mod P, for moduli P < 2^30.
+// Products of two residues fit in 64 bits, so a lane multiply is the 32×32→64
+// multiply every SIMD instruction set has, and up to three products (each
+// < 2^60) can be summed before a single reduction. The lane loops are plain
+// fixed-length loops, vectorized through TILING_SIMD_KERNEL. Larger moduli,
+// and exact counts, go through the scalar engines one query at a time.
+// ---------------------------------------------------------------------------
+const int kLanes = 16;
+const uint64_t kLaneModulusLimit = uint64_t(1) << 30;
+
+// Per-lane constants for a group of kLanes moduli
+struct LaneModuli {
+    uint32_t P[kLanes];
+    uint32_t neg_inv[kLanes];  // -P^-1 mod 2^32
+    uint32_t one[kLanes];      // 2^32 mod P, i.e. 1 in Montgomery form
+
+    void set(int l, uint32_t p) {
+        uint32_t inv = p;
+        for (int i = 0; i < 4; i++) inv *= 2 - p * inv;
+        P[l] = p;
+        neg_inv[l] = ~inv + 1;
+        one[l] = uint32_t((uint64_t(1) << 32) % p);
+    }
+};
+
+// a_{N[l]} mod P[l] for every lane
+TILING_SIMD_KERNEL
+void count_matpow_lanes(const LaneModuli& mod, const uint64_t* N, uint64_t* out) {
+    // x^(2^k) and x^(bits of N so far), reduced mod the characteristic polynomial
+    uint32_t b[3][kLanes], c[3][kLanes], t[3][kLanes];
+    uint64_t bits[kLanes];
+    uint64_t longest = 0;
+    for (int l = 0; l < kLanes; l++) {
+        b[0][l] = b[2][l] = 0;
+        b[1][l] = mod.one[l];
+        c[0][l] = mod.one[l];
+        c[1][l] = c[2][l] = 0;
+        bits[l] = N[l];
+        longest |= N[l];
+    }
+
+    // r = p·q mod (x³ − 3x² − x + 1), lane by lane in one straight-line pass.
+    // Each of the five product coefficients is a sum of at most three products
+    // below P², so it reduces once; then x³ = 3x² + x − 1 and
+    // x⁴ = 10x² + 2x − 3 fold the top two back in, and the sums (< 16P) are
+    // brought below P by conditional subtraction.
+    auto mul = [&](const uint32_t (&p)[3][kLanes], const uint32_t (&q)[3][kLanes], uint32_t (&r)[3][kLanes]) {
+        for (int l = 0; l < kLanes; l++) {
+            const uint64_t P = mod.P[l];
+            const uint32_t ninv = mod.neg_inv[l];
+            auto redc = [&](uint64_t x) {
+                uint32_t m = uint32_t(x) * ninv;
+                uint64_t u = (x + uint64_t(m) * P) >> 32;
+                return (u >= P) ? u - P : u;
+            };
+            auto fold = [&](uint64_t v) {
+                v = (v >= 8 * P) ? v - 8 * P : v;
+                v = (v >= 4 * P) ? v - 4 * P : v;
+                v = (v >= 2 * P) ? v - 2 * P : v;
+                return uint32_t((v >= P) ? v - P : v);
+            };
+            const uint64_t p0 = p[0][l], p1 = p[1][l], p2 = p[2][l];
+            const uint64_t q0 = q[0][l], q1 = q[1][l], q2 = q[2][l];
+            uint64_t d0 = redc(p0 * q0);
+            uint64_t d1 = redc(p0 * q1 + p1 * q0);
+            uint64_t d2 = redc(p0 * q2 + p1 * q1 + p2 * q0);
+            uint64_t d3 = redc(p1 * q2 + p2 * q1);
+            uint64_t d4 = redc(p2 * q2);
+            r[0][l] = fold(d0 + 4 * P - d3 - 3 * d4);
+            r[1][l] = fold(d1 + d3 + 2 * d4);
+            r[2][l] = fold(d2 + 3 * d3 + 10 * d4);
+        }
+    };
+
+    for (; longest > 0; longest >>= 1) {
+        // c·b, kept only in lanes whose current bit is set
+        mul(c, b, t);
+        for (int j = 0; j < 3; j++)
+            for (int l = 0; l < kLanes; l++)
+                c[j][l] = (bits[l] & 1) ? t[j][l] : c[j][l];
+        for (int l = 0; l < kLanes; l++) bits[l] >>= 1;
+
+        if (longest > 1) {
+            mul(b, b, t);
+            std::memcpy(b, t, sizeof b);
+        }
+    }
+
+    // a_N = c0·a_0 + c1·a_1 + c2·a_2, leaving Montgomery form on the way
+    for (int l = 0; l < kLanes; l++) {
+        uint64_t x = c[0][l] + 2 * uint64_t(c[1][l]) + 7 * uint64_t(c[2][l]);
+        uint32_t m = uint32_t(x) * mod.neg_inv[l];
+        uint64_t u = (x + uint64_t(m) * mod.P[l]) >> 32;
+        out[l] = (u >= mod.P[l]) ? u - mod.P[l] : u;
+    }
+}
+
+
+// Counting M×N floors via broken-profile DP
+//
+// count_dp places a whole column at a time, which only works for two rows. For
+// M rows, cells are visited one at a time in column-major order and the
+// profile is an M-bit mask along the "broken" boundary: for the cell at row r,
+// bits 0..r-1 describe the next column (covered by a horizontal tile from this
+// one) and bits r..M-1 the current column (covered from the left, or from
+// above by a vertical tile). At each free cell we place
+//   - a 1×1 tile,
+//   - a horizontal 2×1 tile, setting bit r for the next column, or
+//   - a vertical 2×1 tile, setting bit r+1 if that cell is free.
+//
+// The two layers of 2^M counts come from dp_layers and are swapped after
+// every cell, so nothing is allocated inside the loop. Cost is O(N·M·2^M).
+// ---------------------------------------------------------------------------
+const int kMaxRows = 16;
+
+template <typename T = long long>
+T count_board(int M, long long N) {
+    if (N == 0) return T(1);
+    PhaseTimer timer(kPhaseDp);
+
+    const size_t S = size_t(1) << M;
+    DpLayers<T> dp = dp_layers<T>(S);
+    T* cur = dp.cur;
+    T* nxt = dp.nxt;
+    cur[0] = T(1);
+
+    for (long long col = 0; col < N; col++) {
+        bool last = (col + 1 == N);
+        for (int r = 0; r < M; r++) {
+            const size_t bit = size_t(1) << r;
+            const size_t below = bit << 1;
+            bool vertical_fits = (r + 1 < M);
+            uint64_t transitions = 0;
+            for (size_t mask = 0; mask < S; mask++) {
+                if (cur[mask] == T(0)) continue;
+                transitions++;
+                const T& ways = cur[mask];
+                if (mask & bit) {
+                    // Already covered: the bit now stands for the next column
+                    nxt[mask & ~bit] += ways;
+                    continue;
+                }
+                nxt[mask] += ways;                       // 1×1
+                if (!last) nxt[mask | bit] += ways;      // horizontal
+                if (vertical_fits && !(mask & below))
+                    nxt[mask | below] += ways;           // vertical
+            }
+            STAT_ADD(dp_transitions, transitions);
+            std::swap(cur, nxt);
+            std::fill(nxt, nxt + S, T(0));
+        }
+    }
+
+    return cur[0];
+}
+
+// Counting M×N floors via a cached transfer matrix
+//
+// Taken a whole column at a time, the broken-profile steps compose into one
+// transfer matrix between column profiles, identical for every column: from a
+// profile `in` of cells covered from the left, any subset `out` of the free
+// cells may start a horizontal tile, and the remaining free cells form runs
+// filled by 1×1 and vertical tiles, F(L+1) ways for a run of length L. The
+// matrix has 3^M nonzeros, stored in CSR form by target profile. A column
+// step as a sparse product costs 3^M multiply-adds, more than the DP's
+// per-cell updates for every M, so the matrix is used for what the DP cannot
+// do: repeated squaring, which makes N up to 10^18 feasible for short floors
+// under --mod.
+//
+// The matrix is built once per M and kept for the life of the process. With
+// a cache directory it is also saved as transfer-M<M>.bin and read back by
+// later runs.
+// ---------------------------------------------------------------------------
+struct TransferMatrix {
+    int M = 0;
+    std::vector<uint32_t> start;   // 2^M + 1 offsets into from/weight, by target
+    std::vector<uint32_t> from;    // source profile of each nonzero
+    std::vector<uint32_t> weight;  // number of ways to fill the column
+};
+
+TransferMatrix build_transfer_matrix(int M) {
+    const uint32_t S = uint32_t(1) << M;
+    std::vector<uint32_t> run_ways(M + 2);
+    run_ways[0] = run_ways[1] = 1;
+    for (int L = 2; L <= M + 1; L++) run_ways[L] = run_ways[L - 1] + run_ways[L - 2];
+
+    // Bucket the nonzeros by target profile
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> by_target(S);
+    for (uint32_t in = 0; in < S; in++) {
+        const uint32_t free_cells = ~in & (S - 1);
+        for (uint32_t out = free_cells;; out = (out - 1) & free_cells) {
+            uint32_t rest = free_cells & ~out, w = 1;
+            for (int r = 0, run = 0; r <= M; r++) {
+                if (r < M && (rest >> r & 1)) { run++; continue; }
+                w *= run_ways[run];
+                run = 0;
+            }
+            by_target[out].push_back({in, w});
+            if (out == 0) break;
+        }
+    }
+
+    TransferMatrix T;
+    T.M = M;
+    T.start.reserve(S + 1);
+    T.start.push_back(0);
+    for (auto& column : by_target) {
+        for (auto& e : column) {
+            T.from.push_back(e.first);
+            T.weight.push_back(e.second);
+        }
+        T.start.push_back(uint32_t(T.from.size()));
+    }
+    return T;
+}
+
+// On-disk form: "TMX1", M, nonzero count, then the three arrays, all uint32
+// in host byte order. Anything that does not match is ignored and rebuilt:
+// the offsets must be monotone, every source profile must lie below 2^M and
+// be disjoint from its target, and every weight must be between 1 and the
+// 2×M count, so a corrupted file can never index outside the DP layers.
+bool load_transfer_matrix(const std::string& path, int M, TransferMatrix& T) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    char magic[4];
+    uint32_t m = 0, nnz = 0;
+    in.read(magic, 4);
+    in.read(reinterpret_cast<char*>(&m), 4);
+    in.read(reinterpret_cast<char*>(&nnz), 4);
+    if (!in || std::memcmp(magic, "TMX1", 4) != 0 || m != uint32_t(M)) return false;
+    uint64_t expected = 1;
+    for (int i = 0; i < M; i++) expected *= 3;
+    if (nnz != expected) return false;
+
+    T.M = M;
+    T.start.resize((size_t(1) << M) + 1);
+    T.from.resize(nnz);
+    T.weight.resize(nnz);
+    in.read(reinterpret_cast<char*>(T.start.data()), T.start.size() * 4);
+    in.read(reinterpret_cast<char*>(T.from.data()), T.from.size() * 4);
+    in.read(reinterpret_cast<char*>(T.weight.data()), T.weight.size() * 4);
+    if (!in || T.start.front() != 0 || T.start.back() != nnz) return false;
+
+    const uint32_t S = uint32_t(1) << M;
+    uint32_t max_weight = 1;    // ways to fill an empty column of M cells
+    for (uint32_t prev = 1, L = 2; L <= uint32_t(M); L++) {
+        uint32_t next = max_weight + prev;
+        prev = max_weight;
+        max_weight = next;
+    }
+    for (uint32_t t = 0; t < S; t++) {
+        if (T.start[t] > T.start[t + 1]) return false;
+        for (uint32_t k = T.start[t]; k < T.start[t + 1]; k++)
+            if (T.from[k] >= S || (T.from[k] & t) != 0 ||
+                T.weight[k] == 0 || T.weight[k] > max_weight)
+                return false;
+    }
+    return true;
+}
+
+void save_transfer_matrix(const std::string& path, const TransferMatrix& T) {
+    // Write to a temporary name first so concurrent readers never see a
+    // partial file
+    std::string tmp = path + ".tmp" + std::to_string(::getpid());
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        uint32_t m = T.M, nnz = uint32_t(T.from.size());
+        out.write("TMX1", 4);
+        out.write(reinterpret_cast<const char*>(&m), 4);
+        out.write(reinterpret_cast<const char*>(&nnz), 4);
+        out.write(reinterpret_cast<const char*>(T.start.data()), T.start.size() * 4);
+        out.write(reinterpret_cast<const char*>(T.from.data()), T.from.size() * 4);
+        out.write(reinterpret_cast<const char*>(T.weight.data()), T.weight.size() * 4);
+        if (!out) { std::remove(tmp.c_str()); return; }
+    }
+    std::rename(tmp.c_str(), path.c_str());
+}
+
+// The transfer matrix for M rows, built or loaded at most once per process
+const TransferMatrix& transfer_matrix(int M, const std::string& cache_dir = "") {
+    static std::mutex lock;
+    static std::map<int, TransferMatrix> cache;
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = cache.find(M);
+    if (it != cache.end()) return it->second;
+
+    TransferMatrix T;
+    std::string path = cache_dir.empty() ? "" : cache_dir + "/transfer-M" + std::to_string(M) + ".bin";
+    if (path.empty() || !load_transfer_matrix(path, M, T)) {
+        T = build_transfer_matrix(M);
+        if (!path.empty()) save_transfer_matrix(path, T);
+    }
+    return cache.emplace(M, std::move(T)).first->second;
+}
+
+// a_N as entry (0,0) of the N-th power of the transfer matrix, as in
+// count_matpow: O(4^M) per vector product and O(8^M) per squaring
+template <typename T>
+T count_transfer_matpow(const TransferMatrix& tm, long long N) {
+    const size_t S = size_t(1) << tm.M;
+    std::vector<T> base(S * S, T(0));   // base[from * S + to]
+    for (size_t t = 0; t < S; t++)
+        for (uint32_t k = tm.start[t]; k < tm.start[t + 1]; k++)
+            base[tm.from[k] * S + t] = T(tm.weight[k]);
+
+    std::vector<T> v(S, T(0)), nv(S), sq(S * S);
+    v[0] = T(1);
+    while (N > 0) {
+        if (N & 1) {
+            std::fill(nv.begin(), nv.end(), T(0));
+            for (size_t k = 0; k < S; k++) {
+                if (v[k] == T(0)) continue;
+                const T* row = &base[k * S];
+                for (size_t j = 0; j < S; j++) nv[j] += v[k] * row[j];
+            }
+            v.swap(nv);
+        }
+        N >>= 1;
+        if (N > 0) {
+            std::fill(sq.begin(), sq.end(), T(0));
+            for (size_t i = 0; i < S; i++)
+                for (size_t k = 0; k < S; k++) {
+                    const T a = base[i * S + k];
+                    if (a == T(0)) continue;
+                    const T* row = &base[k * S];
+                    T* out = &sq[i * S];
+                    for (size_t j = 0; j < S; j++) out[j] += a * row[j];
+                }
+            base.swap(sq);
+        }
+    }
+    return v[0];
+}
+
+// Largest height for which the dense matrix power is ever attempted
+const int kTransferMaxRows = 8;
+
+// a_N for M rows in a fixed-width type T: the matrix power when its
+// 2·log2(N)·8^M operations undercut the DP's roughly 2.5·N·M·2^M updates,
+// else the broken-profile DP. Exact BigInt counts always use the DP, for the
+// same reason as kMatpowThreshold.
+template <typename T>
+T count_rows(int M, long long N, const std::string& cache_dir = "") {
+    PhaseTimer timer(kPhaseCounting);
+    if (!std::is_same<T, BigInt>::value && M <= kTransferMaxRows && N > 0) {
+        double S = double(size_t(1) << M);
+        double matpow_cost = 2 * std::log2(double(N)) * S * S * S;
+        double dp_cost = 2.5 * double(N) * M * S;
+        if (matpow_cost < dp_cost) return count_transfer_matpow<T>(transfer_matrix(M, cache_dir), N);
+    }
+    return count_board<T>(M, N);
+}
+
+// An exact M-row count runs the DP's N·M·2^M updates on numbers of O(N·M)
+// bits, so it grows as N²·M²·2^M. Past kExactBoardMaxWork, about 100 s on
+// one core (N ≈ 2,250 at 12 rows, 13,500 at 8, 420 at 16), `count` and
+// `serve` refuse the exact count and point to --mod.
+const double kExactBoardMaxWork = 3e12;
+
+inline bool exact_board_in_reach(int M, long long N) {
+    return double(N) * double(N) * M * M * std::ldexp(1.0, M) <= kExactBoardMaxWork;
+}
+
+// Exact count for an M×N floor: long long while it fits, BigInt beyond. A
+// partial tiling always extends to a full one, so no intermediate count
+// exceeds the answer, and a floating-point pass decides the type up front.
+std::string exact_board_count(int M, long long N, const std::string& cache_dir = "") {
+    if (count_board<double>(M, N) < 4e18) return std::to_string(count_rows<long long>(M, N, cache_dir));
+    return count_board<BigInt>(M, N).to_string();
+}
+
+// Packed tilings
+//
+// A tiling is also a left-to-right sequence of column moves. Entering column c,
+// the profile (as in count_dp) says which cells are already covered by
+// horizontal tiles from column c-1, and the move says what starts in the free
+// cells. Moves are numbered in the order the Enumerator tries them, so
+// comparing move sequences lexicographically matches enumeration order:
+//
+//   profile 0:  0 = 1×1, 1×1   1 = 1×1, horizontal   2 = horizontal, 1×1
+//               3 = horizontal, horizontal           4 = vertical
+//   profile 1:  0 = 1×1 bottom     1 = horizontal bottom   (top covered)
+//   profile 2:  0 = 1×1 top        1 = horizontal top      (bottom covered)
+//   profile 3:  0 = nothing to place
+//
+// Packed form stores 3 bits per column, 21 columns per 64-bit word, so a
+// tiling of up to 21 columns is one word instead of a 2×N byte grid. The text
+// form is one digit per column, e.g. "40" for a vertical tile followed by two
+// 1×1 tiles.
+// ---------------------------------------------------------------------------
+// A 2×N grid of tile labels in one flat column-major array: cell 2·c + r is
+// row r of column c, so cells are stored in the order the Enumerator fills
+// them. grid[r][c] addresses a cell as in a nested vector.
+class Grid {
+public:
+    class Row {
+    public:
+        explicit Row(char* p) : p(p) {}
+        char& operator[](int c) const { return p[2 * c]; }
+
+    private:
+        char* p;
+    };
+    class ConstRow {
+    public:
+        explicit ConstRow(const char* p) : p(p) {}
+        const char& operator[](int c) const { return p[2 * c]; }
+
+    private:
+        const char* p;
+    };
+
+    Grid() : n(0) {}
+    explicit Grid(int N, char fill = '.') : n(N), cells(size_t(2) * N, fill) {}
+
+    int width() const { return n; }
+    Row operator[](int r) { return Row(cells.data() + r); }
+    ConstRow operator[](int r) const { return ConstRow(cells.data() + r); }
+    char* data() { return cells.data(); }
+    const char* data() const { return cells.data(); }
+    void fill(char c) { std::fill(cells.begin(), cells.end(), c); }
+
+private:
+    int n;
+    std::vector<char> cells;
+};
+
+struct ColumnMove {
+    int next;       // profile of the following column
+    char top, bot;  // '1' 1×1, 'H' horizontal start, 'V' vertical, '-' covered
+};
+
+const int kMoveCount[4] = {5, 2, 2, 1};
+const ColumnMove kMoves[4][5] = {
+    {{0, '1', '1'}, {2, '1', 'H'}, {1, 'H', '1'}, {3, 'H', 'H'}, {0, 'V', 'V'}},
+    {{0, '-', '1'}, {2, '-', 'H'}},
+    {{0, '1', '-'}, {1, 'H', '-'}},
+    {{0, '-', '-'}},
+};
+
+const int kMovesPerWord = 21;
+
+inline size_t packed_words(int N) { return size_t(N + kMovesPerWord - 1) / kMovesPerWord; }
+
+inline int packed_move(const uint64_t* words, int c) {
+    return int(words[c / kMovesPerWord] >> (3 * (c % kMovesPerWord))) & 7;
+}
+
+inline void set_packed_move(uint64_t* words, int c, int move) {
+    uint64_t& w = words[c / kMovesPerWord];
+    int shift = 3 * (c % kMovesPerWord);
+    w = (w & ~(uint64_t(7) << shift)) | (uint64_t(move) << shift);
+}
+
+// Move sequence of a labelled grid, written to packed_words(N) words at out
+void pack_tiling(const Grid& grid, uint64_t* out) {
+    int N = grid.width();
+    std::fill(out, out + packed_words(N), 0);
+    int profile = 0;
+    for (int c = 0; c < N; c++) {
+        bool top_h = !(profile & 1) && c + 1 < N && grid[0][c + 1] == grid[0][c];
+        bool bot_h = !(profile & 2) && c + 1 < N && grid[1][c + 1] == grid[1][c];
+        int move;
+        if (profile == 0 && grid[0][c] == grid[1][c]) move = 4;
+        else if (profile == 0) move = 2 * top_h + bot_h;
+        else move = top_h || bot_h;
+        set_packed_move(out, c, move);
+        profile = kMoves[profile][move].next;
+    }
+}
+
+// Place the tiles a move starts in column c, labelling them from label on
+inline void apply_move(Grid& grid, int c, const ColumnMove& m, char& label) {
+    if (m.top != '-') {
+        grid[0][c] = label;
+        if (m.top == 'H') grid[0][c + 1] = label;
+        if (m.top == 'V') grid[1][c] = label;
+        label++;
+    }
+    if (m.bot != '-' && m.bot != 'V') {
+        grid[1][c] = label;
+        if (m.bot == 'H') grid[1][c + 1] = label;
+        label++;
+    }
+}
+
+// Rebuild the grid, labelling tiles in the order the Enumerator places them.
+// grid must already be 2×N.
+void unpack_tiling(const uint64_t* in, Grid& grid) {
+    int N = grid.width();
+    char label = 'A';
+    int profile = 0;
+    for (int c = 0; c < N; c++) {
+        const ColumnMove& m = kMoves[profile][packed_move(in, c)];
+        apply_move(grid, c, m, label);
+        profile = m.next;
+    }
+}
+
+// A single packed tiling that owns its words
+struct PackedTiling {
+    int N = 0;
+    std::vector<uint64_t> words;
+
+    PackedTiling() {}
+    explicit PackedTiling(int n) : N(n), words(packed_words(n), 0) {}
+    explicit PackedTiling(const Grid& grid) : PackedTiling(grid.width()) {
+        pack_tiling(grid, words.data());
+    }
+
+    int move(int c) const { return packed_move(words.data(), c); }
+    void set_move(int c, int m) { set_packed_move(words.data(), c, m); }
+
+    Grid to_grid() const {
+        Grid grid(N);
+        unpack_tiling(words.data(), grid);
+        return grid;
+    }
+};
+
+// Text form: one move digit per column
+std::string encode_tiling(const PackedTiling& t) {
+    std::string s(t.N, '0');
+    for (int c = 0; c < t.N; c++) s[c] = char('0' + t.move(c));
+    return s;
+}
+
+// Parse the text form; rejects moves invalid for their profile and horizontal
+// tiles running off the right edge
+bool decode_tiling(const std::string& s, PackedTiling& t) {
+    t = PackedTiling(int(s.size()));
+    int profile = 0;
+    for (int c = 0; c < t.N; c++) {
+        int move = s[c] - '0';
+        if (move < 0 || move >= kMoveCount[profile]) return false;
+        t.set_move(c, move);
+        profile = kMoves[profile][move].next;
+    }
+    return profile == 0;
+}
+
+// Ranking and unranking
+//
+// The rank of a tiling is its 0-based position in enumeration order (the
+// Enumerator prints rank r as "Tiling #r+1"). Walking the columns, every move
+// that sorts before the chosen one skips past all tilings that make that move
+// instead, and that number is a suffix count of the same profile DP as
+// count_dp, run right to left. Both directions are O(N) after the O(N) table.
+// ---------------------------------------------------------------------------
+
+// suffix[L][p]: ways to tile the last L columns when the first of them has
+// profile p; suffix[L][0] = a_L
+template <typename T>
+std::vector<std::array<T, 4>> suffix_counts(int N) {
+    std::vector<std::array<T, 4>> suffix(N + 1);
+    suffix[0] = {T(1), T(0), T(0), T(0)};
+    for (int L = 1; L <= N; L++) {
+        for (int p = 0; p < 4; p++) {
+            T total(0);
+            for (int j = 0; j < kMoveCount[p]; j++)
+                total += suffix[L - 1][kMoves[p][j].next];
+            suffix[L][p] = total;
+        }
+    }
+    return suffix;
+}
+
+template <typename T>
+T rank_tiling(const PackedTiling& t, const std::vector<std::array<T, 4>>& suffix) {
+    T rank(0);
+    int profile = 0;
+    for (int c = 0; c < t.N; c++) {
+        int move = t.move(c);
+        for (int j = 0; j < move; j++)
+            rank += suffix[t.N - c - 1][kMoves[profile][j].next];
+        profile = kMoves[profile][move].next;
+    }
+    return rank;
+}
+
+// The tiling of rank k; requires 0 <= k < a_N
+template <typename T>
+PackedTiling unrank_tiling(int N, T k, const std::vector<std::array<T, 4>>& suffix) {
+    PackedTiling t(N);
+    int profile = 0;
+    for (int c = 0; c < N; c++) {
+        int move = 0;
+        for (;; move++) {
+            const T& skip = suffix[N - c - 1][kMoves[profile][move].next];
+            if (k < skip || move + 1 == kMoveCount[profile]) break;
+            k -= skip;
+        }
+        t.set_move(c, move);
+        profile = kMoves[profile][move].next;
+    }
+    return t;
+}
+
+// Uniform random tilings
+//
+// Drawing each column's move with probability proportional to the number of
+// tilings that complete it (the suffix counts used for ranking) gives every
+// tiling the same probability, with no backtracking. The probabilities depend
+// only on ratios of suffix counts, so they are computed once in normalised long
+// double form and stored as cumulative 63-bit cutoffs: one RNG call and at most
+// four compares per column. The ratios converge after a few dozen columns, so
+// only the rows up to convergence are kept and N can be arbitrarily large.
+// Moves are uniform to within the 2^-63 resolution of the cutoffs.
+// ---------------------------------------------------------------------------
+class TilingSampler {
+public:
+    explicit TilingSampler(int n) : N(n) {
+        std::array<long double, 4> prev = {1, 0, 0, 0};  // normalised suffix counts, L-1
+        for (int L = 1; L <= N; L++) {
+            Cutoffs row{};
+            std::array<long double, 4> cur{};
+            for (int p = 0; p < 4; p++) {
+                long double total = 0;
+                for (int j = 0; j < kMoveCount[p]; j++) total += prev[kMoves[p][j].next];
+                long double cum = 0;
+                for (int j = 0; j + 1 < kMoveCount[p]; j++) {
+                    cum += prev[kMoves[p][j].next];
+                    row[p][j] = uint64_t(cum / total * kScale);
+                }
+                for (int j = kMoveCount[p] - 1; j < 5; j++) row[p][j] = uint64_t(kScale);
+                cur[p] = total;
+            }
+            long double norm = cur[0];
+            for (int p = 0; p < 4; p++) cur[p] /= norm;
+
+            if (!cutoffs.empty() && row == cutoffs.back()) break;  // converged
+            cutoffs.push_back(row);
+            prev = cur;
+        }
+    }
+
+    // Draw one tiling into packed_words(N) words
+    template <typename Rng>
+    void sample(Rng& rng, uint64_t* words) const {
+        std::fill(words, words + packed_words(N), 0);
+        int profile = 0;
+        for (int c = 0; c < N; c++) {
+            size_t L = size_t(N - c);
+            const std::array<uint64_t, 5>& cut = cutoffs[std::min(L, cutoffs.size()) - 1][profile];
+            uint64_t u = rng() >> 1;
+            int move = 0;
+            while (u >= cut[move]) move++;
+            set_packed_move(words, c, move);
+            profile = kMoves[profile][move].next;
+        }
+    }
+
+private:
+    typedef std::array<std::array<uint64_t, 5>, 4> Cutoffs;  // [profile][move]
+
+    static constexpr long double kScale = 9223372036854775808.0L;  // 2^63
+    int N;
+    std::vector<Cutoffs> cutoffs;  // cutoffs[L-1]: L columns left, incl. this one
+};
+
+// Enumeration via backtracking
+//
+// Scan cells left-to-right, top-to-bottom. At each empty cell, try:
+//   1. Place a 1×1 tile
+//   2. Place a horizontal 2×1 tile (if the cell to the right is empty)
+//   3. Place a vertical 2×1 tile (if the cell below is empty)
+// and hand each complete grid to a visitor as soon as it is found. The grid is
+// the enumerator's own buffer, so nothing is allocated per tiling; a visitor
+// that needs to keep a tiling must copy it. A visitor that returns bool stops
+// the search by returning false.
+//
+// Every cell before the one being filled is covered, so the search carries a
+// cursor into the flat grid instead of rescanning from column 0. It also
+// carries which of the next two cells a tile already reaches, since no other
+// cell past the cursor can be covered yet. Emptiness is therefore never read
+// from the labels, which wrap after 256 tiles and can take any byte value.
+// Each call owns its copies, so backtracking restores them for free. The next
+// empty cell is at most two cells ahead, which makes each node O(1) and the
+// whole enumeration O(a_N).
+struct Enumerator {
+    int N;
+    // Tile labels (A, B, C, ...)
+    Grid grid;
+    char next_label;
+    bool halted;
+
+    Enumerator(int n) : N(n), grid(n), next_label('A'), halted(false) {}
+
+    // Advance cell, an index in scan order (2·col + row), to the next empty
+    // cell; bits 0 and 1 of covered mark cell and cell + 1 as reached by a
+    // tile. False once the grid is full.
+    bool find_next_empty(int& cell, int& covered) const {
+        [[maybe_unused]] int start = cell;  // read only by the stats counters
+        for (; covered & 1; covered >>= 1) cell++;
+        STAT_ADD(empty_scans, 1);
+        STAT_ADD(scanned_cells, cell - start + (cell < 2 * N));
+        return cell < 2 * N;
+    }
+
+    template <typename Visitor>
+    void solve(Visitor& visit, int cell, int covered) {
+        STAT_ADD(dfs_nodes, 1);
+        if (!find_next_empty(cell, covered)) {
+            // All cells filled — report this tiling
+            const Grid& done = grid;
+            if constexpr (std::is_same<decltype(visit(done)), bool>::value) {
+                if (!visit(done)) halted = true;
+            } else {
+                visit(done);
+            }
+            return;
+        }
+
+        char* g = grid.data();
+        char label = next_label++;
+        bool top = (cell & 1) == 0;
+        int next_covered = covered >> 1;  // whether cell + 1 is reached
+
+        // Option 1: place a 1×1 tile
+        g[cell] = label;
+        solve(visit, cell + 1, next_covered);
+        if (halted) return;
+
+        // Option 2: place a horizontal 2×1 tile (extends right, two cells on)
+        if (cell + 2 < 2 * N) {
+            g[cell + 2] = label;
+            solve(visit, cell + 1, next_covered | 2);
+            if (halted) return;
+        }
+
+        // Option 3: place a vertical 2×1 tile (extends down, the next cell)
+        if (top && !next_covered) {
+            g[cell + 1] = label;
+            solve(visit, cell + 2, 0);
+            if (halted) return;
+        }
+
+        next_label--;
+    }
+
+    template <typename Visitor>
+    void enumerate(Visitor&& visit) {
+        enumerate_prefix(std::vector<int>(), visit);
+    }
+
+    // Enumerate only the subtree below a prefix of column moves: the prefix is
+    // placed with the labels solve would have given it, then solve continues
+    template <typename Visitor>
+    void enumerate_prefix(const std::vector<int>& moves, Visitor&& visit) {
+        PhaseTimer timer(kPhaseSearch);
+        grid.fill('.');
+        next_label = 'A';
+        halted = false;
+        int profile = 0;
+        for (int c = 0; c < (int)moves.size(); c++) {
+            const ColumnMove& m = kMoves[profile][moves[c]];
+            apply_move(grid, c, m, next_label);
+            profile = m.next;
+        }
+        solve(visit, 2 * int(moves.size()), profile);
+    }
+};
+
+// Calls visit(grid) for every tiling of a 2×N floor, in enumeration order
+template <typename Visitor>
+void for_each_tiling(int N, Visitor&& visit) {
+    Enumerator en(N);
+    en.enumerate(visit);
+}
+
+// Calls visit(grid) for the tilings of rank offset .. offset+limit-1, in
+// enumeration order. The subtrees to visit are read off the move sequence of
+// the first tiling: the tiling itself, then, from the last column back to the
+// first, every larger move at that column. Work is proportional to the slice,
+// plus the O(N) suffix table and unranking.
+template <typename T, typename Visitor>
+void for_each_tiling_slice(int N, const T& offset, long long limit, Visitor&& visit) {
+    auto suffix = suffix_counts<T>(N);
+    if (limit <= 0 || !(offset < suffix[N][0])) return;
+
+    PackedTiling first = unrank_tiling(N, offset, suffix);
+    std::vector<int> moves(N), profiles(N);
+    for (int c = 0, profile = 0; c < N; c++) {
+        moves[c] = first.move(c);
+        profiles[c] = profile;
+        profile = kMoves[profile][moves[c]].next;
+    }
+
+    long long left = limit;
+    Enumerator en(N);
+    auto take = [&](const Grid& grid) {
+        visit(grid);
+        return --left > 0;
+    };
+    en.enumerate_prefix(moves, take);
+    for (int c = N - 1; c >= 0 && left > 0; c--) {
+        std::vector<int> prefix(moves.begin(), moves.begin() + c + 1);
+        for (int j = moves[c] + 1; j < kMoveCount[profiles[c]] && left > 0; j++) {
+            if (c + 1 == N && kMoves[profiles[c]][j].next != 0) continue;
+            prefix[c] = j;
+            en.enumerate_prefix(prefix, take);
+        }
+    }
+}
+
+// Calls visit(words) with each tiling packed into packed_words(N) words; the
+// words are a reused buffer, valid only during the call
+template <typename Visitor>
+void for_each_packed_tiling(int N, Visitor&& visit) {
+    std::vector<uint64_t> words(packed_words(N));
+    for_each_tiling(N, [&](const Grid& grid) {
+        pack_tiling(grid, words.data());
+        visit(static_cast<const uint64_t*>(words.data()));
+    });
+}
+
+// ASCII rendering
+//
+// Each tiling is drawn as five lines of 4N + 1 characters under a
+// "Tiling #index:" header: the top border, the top row, the middle border, the
+// bottom row and the bottom border. A 1×1 tile is a 3-wide cell showing "1".
+// A vertical tile shows "2" in both rows with no border between them. A
+// horizontal tile is one 7-wide merged cell showing "2". Every column adds
+// exactly four characters to every line, so the text size is known up front.
+// render_tiling copies each column's 4-byte template straight into a
+// caller's buffer, with no allocation and no stream calls.
+//
+// A cell's size is 2 when its label occurs twice in the grid. Labels are
+// chars and wrap after 256 tiles, so in very long grids a 1×1 tile can share
+// a label with another tile and show "2". This matches the labelling the
+// output has always had.
+// ---------------------------------------------------------------------------
+// Bytes render_tiling writes for a 2×N tiling with an index of index_len digits
+inline size_t tiling_text_size(int N, size_t index_len) {
+    return 8 + index_len + 2 + 5 * (4 * size_t(N) + 2) + 1;
+}
+
+// Render one tiling into out, which has room for tiling_text_size bytes;
+// returns the bytes written
+size_t render_tiling(const Grid& grid, const char* index, size_t index_len, char* out) {
+    PhaseTimer timer(kPhaseFormat);
+    const int N = grid.width();
+    const unsigned char* g = reinterpret_cast<const unsigned char*>(grid.data());  // g[2c + r]
+
+    // uses[label]: 1 if seen once, 2 if more
+    unsigned char uses[256];
+    for (int i = 0; i < 2 * N; i++) uses[g[i]] = 0;
+    for (int i = 0; i < 2 * N; i++) uses[g[i]] = uses[g[i]] ? 2 : 1;
+
+    char* p = out;
+    std::memcpy(p, "Tiling #", 8);
+    std::memcpy(p + 8, index, index_len);
+    p += 8 + index_len;
+    *p++ = ':';
+    *p++ = '\n';
+
+    // Outer border below or above row r: a horizontal span continues with '-'
+    auto outer_border = [&](int r) {
+        *p++ = '+';
+        for (int c = 0; c < N; c++, p += 4)
+            std::memcpy(p, c + 1 < N && g[2 * c + r] == g[2 * c + 2 + r] ? "----" : "---+", 4);
+        *p++ = '\n';
+    };
+    auto content_row = [&](int r) {
+        *p++ = '|';
+        for (int c = 0; c < N;) {
+            char size = char('0' + uses[g[2 * c + r]]);
+            if (c + 1 < N && g[2 * c + r] == g[2 * c + 2 + r]) {
+                std::memcpy(p, "   2   |", 8);
+                p[3] = size;
+                p += 8;
+                c += 2;
+            } else {
+                std::memcpy(p, " 1 |", 4);
+                p[1] = size;
+                p += 4;
+                c++;
+            }
+        }
+        *p++ = '\n';
+    };
+
+    outer_border(0);
+    content_row(0);
+    // Middle border: open over vertical tiles
+    *p++ = '+';
+    for (int c = 0; c < N; c++, p += 4) std::memcpy(p, g[2 * c] == g[2 * c + 1] ? "   +" : "---+", 4);
+    *p++ = '\n';
+    content_row(1);
+    outer_border(1);
+    *p++ = '\n';
+    return size_t(p - out);
+}
+
+// Print a single tiling as ASCII art with numeric labels and merged cells
+// index is the 1-based position shown in the header, as a decimal string so
+// that tilings far down a long enumeration can be labelled too
+void print_tiling(const Grid& grid, const std::string& index,
+                  std::ostream& os = std::cout) {
+    thread_local std::vector<char> text;
+    size_t need = tiling_text_size(grid.width(), index.size());
+    if (text.size() < need) text.resize(need);
+    os.write(text.data(), render_tiling(grid, index.data(), index.size(), text.data()));
+}
+
+void print_tiling(const Grid& grid, int index) {
+    print_tiling(grid, std::to_string(index));
+}
+
+// Print a packed tiling, unpacking into a caller-provided 2×N scratch grid
+void print_tiling(const uint64_t* words, Grid& scratch, int index) {
+    unpack_tiling(words, scratch);
+    print_tiling(scratch, index);
+}
+
+void print_tiling(const PackedTiling& t, int index) {
+    print_tiling(t.to_grid(), index);
+}
+
+// Buffered output
+//
+// Formats straight into one large buffer and hands it to write(2) in big
+// blocks, bypassing iostreams and the locale. Integers go through
+// std::to_chars. With a string sink the blocks are appended to the string
+// instead, for callers that write them out themselves.
+// ---------------------------------------------------------------------------
+class OutBuf {
+public:
+    explicit OutBuf(int fd = 1, size_t capacity = size_t(1) << 20)
+        : fd(fd), buf(capacity), pos(0) {}
+    explicit OutBuf(std::string& sink, size_t capacity = size_t(1) << 16)
+        : fd(-1), sink(&sink), buf(capacity), pos(0) {}
+    ~OutBuf() { flush(); }
+    OutBuf(const OutBuf&) = delete;
+    OutBuf& operator=(const OutBuf&) = delete;
+
+    void write(const char* p, size_t n) {
+        if (n > buf.size() - pos) {
+            flush();
+            if (n > buf.size()) { write_all(p, n); return; }
+        }
+        std::memcpy(buf.data() + pos, p, n);
+        pos += n;
+    }
+    void put(char c) {
+        if (pos == buf.size()) flush();
+        buf[pos++] = c;
+    }
+    void put(const std::string& s) { write(s.data(), s.size()); }
+    void put_uint(unsigned long long v) {
+        char tmp[20];
+        char* end = std::to_chars(tmp, tmp + sizeof(tmp), v).ptr;
+        write(tmp, end - tmp);
+    }
+    // Right-align in a field of the given width, like std::setw
+    void put_padded(const char* p, size_t n, size_t width) {
+        for (; width > n; width--) put(' ');
+        write(p, n);
+    }
+    // Room for n bytes at the write position; commit() the bytes filled in
+    char* reserve(size_t n) {
+        if (n > buf.size() - pos) {
+            flush();
+            if (n > buf.size()) buf.resize(n);
+        }
+        return buf.data() + pos;
+    }
+    void commit(size_t n) { pos += n; }
+    // Little-endian fixed-width integer
+    void put_le(uint64_t v, int bytes) {
+        if (size_t(bytes) > buf.size() - pos) flush();
+        for (int i = 0; i < bytes; i++) buf[pos++] = char(v >> (8 * i));
+    }
+
+    void flush() {
+        write_all(buf.data(), pos);
+        pos = 0;
+    }
+
+private:
+    int fd;
+    std::string* sink = nullptr;
+    std::vector<char> buf;
+    size_t pos;
+
+    void write_all(const char* p, size_t n) {
+        PhaseTimer timer(kPhaseOutput);
+        STAT_ADD(bytes_written, n);
+        if (sink) { sink->append(p, n); return; }
+        while (n > 0) {
+            ssize_t w = ::write(fd, p, n);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            p += w;
+            n -= size_t(w);
+        }
+    }
+};
+
+// Render a tiling straight into the output buffer
+void print_tiling(const Grid& grid, const char* index, size_t index_len, OutBuf& out) {
+    out.commit(render_tiling(grid, index, index_len, out.reserve(tiling_text_size(grid.width(), index_len))));
+}
+
+void print_tiling(const Grid& grid, long long index, OutBuf& out) {
+    char digits[20];
+    char* end = std::to_chars(digits, digits + sizeof(digits), index).ptr;
+    print_tiling(grid, digits, end - digits, out);
+}
+
+// Streaming table output
+//
+// `table` makes one pass of the recurrence, carrying the three live terms
+// forward, and writes each row as it is produced. Binary rows are
+// little-endian: one uint64 per residue under --mod, otherwise a uint32 limb
+// count followed by that many uint32 limbs, least significant first.
+// ---------------------------------------------------------------------------
+enum class TableFormat { Text, Csv, Tsv, Binary };
+
+// Exact terms held in base 10^9, so an exact text table prints each row in
+// linear time instead of converting every BigInt from binary
+class DecimalBig {
+public:
+    static const uint32_t kBase = 1000000000;
+
+    DecimalBig(unsigned long long v = 0) {
+        for (; v != 0; v /= kBase) chunks.push_back(uint32_t(v % kBase));
+    }
+    explicit DecimalBig(const BigInt& v) {
+        std::string s = v.to_string();
+        if (s == "0") return;
+        for (size_t end = s.size(); end > 0; end = (end > 9) ? end - 9 : 0) {
+            size_t begin = (end > 9) ? end - 9 : 0;
+            chunks.push_back(uint32_t(std::stoul(s.substr(begin, end - begin))));
+        }
+    }
+
+    // *this = 3*a2 + a1 - *this, as BigInt::recur
+    void recur(const DecimalBig& a1, const DecimalBig& a2) {
+        size_t n = std::max(std::max(chunks.size(), a1.chunks.size()), a2.chunks.size());
+        size_t n1 = a1.chunks.size(), n2 = a2.chunks.size();
+        chunks.resize(n, 0);
+        int64_t carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            int64_t v = carry - int64_t(chunks[i]);
+            if (i < n1) v += a1.chunks[i];
+            if (i < n2) v += 3 * int64_t(a2.chunks[i]);
+            carry = (v >= 0) ? v / kBase : -((kBase - 1 - v) / kBase);
+            chunks[i] = uint32_t(v - carry * kBase);
+        }
+        if (carry > 0) chunks.push_back(uint32_t(carry));
+        while (!chunks.empty() && chunks.back() == 0) chunks.pop_back();
+    }
+
+    // Replace out with the decimal digits
+    void digits(std::string& out) const {
+        out.clear();
+        if (chunks.empty()) { out = "0"; return; }
+        char tmp[10];
+        char* end = std::to_chars(tmp, tmp + sizeof(tmp), chunks.back()).ptr;
+        out.append(tmp, end);
+        for (size_t i = chunks.size() - 1; i-- > 0;) {
+            end = std::to_chars(tmp, tmp + sizeof(tmp), chunks[i]).ptr;
+            out.append(9 - (end - tmp), '0');
+            out.append(tmp, end);
+        }
+    }
+
+private:
+    std::vector<uint32_t> chunks;  // least significant first
+};
+
+inline void recurrence_step(DecimalBig& a0, const DecimalBig& a1, const DecimalBig& a2) {
+    a0.recur(a1, a2);
+}
+
+bool parse_table_format(const std::string& s, TableFormat& format) {
+    if (s == "text") format = TableFormat::Text;
+    else if (s == "csv") format = TableFormat::Csv;
+    else if (s == "tsv") format = TableFormat::Tsv;
+    else if (s == "binary") format = TableFormat::Binary;
+    else return false;
+    return true;
+}
+
+struct TableWriter {
+    OutBuf& out;
+    TableFormat format;
+    std::string scratch;  // reused digit buffer for exact rows
+
+    void header(long long from, long long to, const std::string& mod) {
+        if (format == TableFormat::Csv) out.put("N,a_N\n");
+        else if (format == TableFormat::Tsv) out.put("N\ta_N\n");
+        if (format != TableFormat::Text) return;
+
+        out.put("Tiling counts a_" + std::to_string(from) + " through a_");
+        out.put(std::to_string(to));
+        if (!mod.empty()) out.put(" (mod " + mod + ")");
+        out.put(":\n\n");
+        out.put_padded("N", 1, 5);
+        out.put(" | ");
+        out.put_padded("a_N", 3, 20);
+        out.put("\n" + std::string(30, '-') + "\n");
+    }
+
+    // A text row from the decimal digits of a_i
+    void row(long long i, const char* digits, size_t n) {
+        char idx[20];
+        char* end = std::to_chars(idx, idx + sizeof(idx), i).ptr;
+        if (format == TableFormat::Text) {
+            out.put_padded(idx, end - idx, 5);
+            out.write(" | ", 3);
+            out.put_padded(digits, n, 20);
+        } else {
+            out.write(idx, end - idx);
+            out.put(format == TableFormat::Csv ? ',' : '\t');
+            out.write(digits, n);
+        }
+        out.put('\n');
+    }
+
+    void term(long long i, long long v) {
+        if (format == TableFormat::Binary) {
+            uint64_t u = uint64_t(v);
+            int limbs = (u >> 32) ? 2 : (u ? 1 : 0);
+            out.put_le(limbs, 4);
+            out.put_le(u, 4 * limbs);
+            return;
+        }
+        char tmp[20];
+        char* end = std::to_chars(tmp, tmp + sizeof(tmp), v).ptr;
+        row(i, tmp, end - tmp);
+    }
+
+    void term(long long i, const ModInt& v) {
+        if (format == TableFormat::Binary) { out.put_le(v.value(), 8); return; }
+        char tmp[20];
+        char* end = std::to_chars(tmp, tmp + sizeof(tmp), v.value()).ptr;
+        row(i, tmp, end - tmp);
+    }
+
+    void term(long long i, const BigInt& v) {
+        if (format == TableFormat::Binary) {
+            out.put_le(v.size(), 4);
+            for (uint32_t limb : v.data()) out.put_le(limb, 4);
+            return;
+        }
+        scratch = v.to_string();
+        row(i, scratch.data(), scratch.size());
+    }
+
+    void term(long long i, const DecimalBig& v) {
+        v.digits(scratch);
+        row(i, scratch.data(), scratch.size());
+    }
+};
+
+// Rows from..to, given the three terms a_from, a_{from+1}, a_{from+2}
+template <typename T>
+void stream_table(TableWriter& w, long long from, long long to, T t0, T t1, T t2) {
+    for (long long i = from; i <= to; i++) {
+        w.term(i, t0);
+        recurrence_step(t0, t1, t2);
+        std::swap(t0, t1);
+        std::swap(t1, t2);
+    }
+}
+
+// Precomputed table files
+//
+// `build-table N FILE` stores a_0..a_N so that later processes answer point
+// queries from FILE through mmap without computing anything: opening checks
+// the 64-byte header, and a lookup touches only the pages holding that term.
+// Startup cost is therefore independent of N.
+//
+// Layout, all integers in host byte order:
+//   header    TableFileHeader; header_checksum covers the fields before it
+//   int64     kind 1: exact terms a_0..a_N as int64 (N <= kMaxLongLongN)
+//   modular   kind 2: residues mod `modulus` as uint64
+//   bignum    kind 3: the uint32 limbs of every term back to back, padded to
+//             8 bytes, then at index_offset N+2 uint64 limb offsets; term i
+//             is limbs [offset[i], offset[i+1])
+// payload_checksum is FNV-1a over all bytes after the header. Checking it
+// reads the whole file, so `--table-file` leaves that to `check-table`: a
+// lookup trusts the payload, and the usage text says so.
+// ---------------------------------------------------------------------------
+enum TableFileKind : uint32_t { kTableInt64 = 1, kTableModular = 2, kTableBig = 3 };
+
+const uint32_t kTableFileVersion = 1;
+
+struct TableFileHeader {
+    char magic[8];               // "TILETBL\0"
+    uint32_t version;
+    uint32_t kind;
+    uint64_t terms;              // a_0 .. a_{terms-1}
+    uint64_t modulus;            // 0 for exact tables
+    uint64_t index_offset;       // kTableBig only
+    uint64_t file_size;
+    uint64_t payload_checksum;
+    uint64_t header_checksum;
+};
+static_assert(sizeof(TableFileHeader) == 64, "table file header is 64 bytes");
+
+const uint64_t kFnvOffset = 14695981039346656037ULL;
+
+inline uint64_t fnv1a(uint64_t h, const void* data, size_t n) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; i++) h = (h ^ p[i]) * 1099511628211ULL;
+    return h;
+}
+
+// Writes FILE through a temporary name, tracking the payload checksum
+class TableFileWriter {
+public:
+    TableFileWriter(const std::string& path, uint32_t kind, uint64_t terms, uint64_t modulus)
+        : path(path), tmp(path + ".tmp" + std::to_string(::getpid())), out(tmp, std::ios::binary) {
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, "TILETBL", 8);
+        h.version = kTableFileVersion;
+        h.kind = kind;
+        h.terms = terms;
+        h.modulus = modulus;
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));  // rewritten by finish
+        h.payload_checksum = kFnvOffset;
+    }
+
+    void write(const void* data, size_t n) {
+        out.write(static_cast<const char*>(data), std::streamsize(n));
+        h.payload_checksum = fnv1a(h.payload_checksum, data, n);
+        written += n;
+    }
+    uint64_t offset() const { return sizeof(h) + written; }
+    void set_index_offset(uint64_t at) { h.index_offset = at; }
+
+    bool finish() {
+        h.file_size = offset();
+        h.header_checksum = fnv1a(kFnvOffset, &h, offsetof(TableFileHeader, header_checksum));
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.close();
+        if (!out) { std::remove(tmp.c_str()); return false; }
+        return std::rename(tmp.c_str(), path.c_str()) == 0;
+    }
+
+private:
+    std::string path, tmp;
+    std::ofstream out;
+    TableFileHeader h;
+    uint64_t written = 0;
+};
+
+// a_0..a_N into FILE: residues when modulus != 0, otherwise exact terms
+bool build_table_file(const std::string& path, long long N, uint64_t modulus) {
+    uint64_t terms = uint64_t(N) + 1;
+    if (modulus != 0) {
+        TableFileWriter w(path, kTableModular, terms, modulus);
+        ModInt a0(1), a1(2), a2(7);
+        for (long long i = 0; i <= N; i++) {
+            uint64_t v = a0.value();
+            w.write(&v, 8);
+            recurrence_step(a0, a1, a2);
+            std::swap(a0, a1);
+            std::swap(a1, a2);
+        }
+        return w.finish();
+    }
+    if (N <= kMaxLongLongN) {
+        TableFileWriter w(path, kTableInt64, terms, 0);
+        for (long long i = 0; i <= N; i++) {
+            int64_t v = count_recurrence<long long>(i);
+            w.write(&v, 8);
+        }
+        return w.finish();
+    }
+
+    TableFileWriter w(path, kTableBig, terms, 0);
+    std::vector<uint64_t> index(1, 0);
+    index.reserve(terms + 1);
+    BigInt a0(1), a1(2), a2(7);
+    for (long long i = 0; i <= N; i++) {
+        w.write(a0.data().data(), a0.size() * 4);
+        index.push_back(index.back() + a0.size());
+        recurrence_step(a0, a1, a2);
+        std::swap(a0, a1);
+        std::swap(a1, a2);
+    }
+    if (index.back() % 2) {
+        uint32_t pad = 0;
+        w.write(&pad, 4);
+    }
+    w.set_index_offset(w.offset());
+    w.write(index.data(), index.size() * 8);
+    return w.finish();
+}
+
+// A table file mapped read-only
+class TableFile {
+public:
+    TableFile() {}
+    ~TableFile() { if (base) ::munmap(const_cast<unsigned char*>(base), size); }
+    TableFile(const TableFile&) = delete;
+    TableFile& operator=(const TableFile&) = delete;
+
+    // Map FILE and check its header; on failure `error` says why
+    bool open(const std::string& path, std::string& error) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { error = std::strerror(errno); return false; }
+        struct stat st;
+        void* p = MAP_FAILED;
+        if (::fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(TableFileHeader))
+            p = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) { error = "not a table file"; return false; }
+        base = static_cast<const unsigned char*>(p);
+        size = size_t(st.st_size);
+        std::memcpy(&h, base, sizeof(h));
+
+        if (std::memcmp(h.magic, "TILETBL", 8) != 0) { error = "not a table file"; return false; }
+        if (h.version != kTableFileVersion) { error = "unsupported version " + std::to_string(h.version); return false; }
+        if (h.header_checksum != fnv1a(kFnvOffset, &h, offsetof(TableFileHeader, header_checksum)) ||
+            h.file_size != size || h.terms == 0) {
+            error = "corrupt header";
+            return false;
+        }
+        uint64_t payload = size - sizeof(h);
+        bool fits = (h.kind == kTableInt64 || h.kind == kTableModular) ? payload == 8 * h.terms
+                  : h.kind == kTableBig && h.index_offset % 8 == 0 && h.index_offset <= size &&
+                    (size - h.index_offset) == 8 * (h.terms + 1);
+        if (!fits || (h.kind == kTableModular) != (h.modulus != 0)) {
+            error = "corrupt header";
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t terms() const { return h.terms; }
+    uint64_t modulus() const { return h.modulus; }
+
+    // a_N in decimal (as a residue for a modular table), for N < terms();
+    // false if the index points outside the file
+    bool term(long long N, std::string& out) const {
+        const unsigned char* payload = base + sizeof(h);
+        if (h.kind == kTableInt64) { out = std::to_string(load<int64_t>(payload + 8 * N)); return true; }
+        if (h.kind == kTableModular) { out = std::to_string(load<uint64_t>(payload + 8 * N)); return true; }
+        const unsigned char* index = base + h.index_offset;
+        uint64_t from = load<uint64_t>(index + 8 * N), to = load<uint64_t>(index + 8 * (N + 1));
+        if (from > to || to > (h.index_offset - sizeof(h)) / 4) return false;
+        std::vector<uint32_t> limbs(to - from);
+        std::memcpy(limbs.data(), payload + 4 * from, 4 * limbs.size());
+        out = BigInt(std::move(limbs)).to_string();
+        return true;
+    }
+
+    // Every byte checked against payload_checksum
+    bool check_payload() const {
+        return fnv1a(kFnvOffset, base + sizeof(h), size - sizeof(h)) == h.payload_checksum;
+    }
+
+private:
+    template <typename U>
+    static U load(const unsigned char* p) {
+        U v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    const unsigned char* base = nullptr;
+    size_t size = 0;
+    TableFileHeader h;
+};
+
+// Tiling dump files
+//
+// `enumerate --format=bin` writes every selected tiling as a fixed-width
+// record: a 64-byte header, then `count` records of packed_words(N) uint64
+// words, the packed move sequence with 3 bits per column. The records follow
+// enumeration order from rank first_rank. That is 8 bytes per tiling up to
+// N = 21, against about 20 bytes per column in ASCII.
+//
+// TilingFile maps a dump read-only and hands out records in place, so
+// iterating decodes nothing and copies nothing. The header is 64 bytes and
+// records are whole words, so every record is 8-byte aligned in the mapping
+// (and in numpy.memmap with offset=64). Integers are in host byte order. The
+// header carries a checksum of its own fields; the records are written as
+// they are enumerated and have none.
+// ---------------------------------------------------------------------------
+const uint32_t kTilingFileVersion = 1;
+const uint32_t kTilingPacked3 = 1;  // 3-bit column moves, kMovesPerWord per word
+
+struct TilingFileHeader {
+    char magic[8];          // "TILEBIN\0"
+    uint32_t version;
+    uint32_t encoding;
+    uint64_t N;
+    uint64_t count;         // records after the header
+    uint64_t first_rank;    // rank of the first record
+    uint32_t words;         // uint64 words per record
+    uint32_t reserved;
+    uint64_t reserved2;
+    uint64_t header_checksum;
+};
+static_assert(sizeof(TilingFileHeader) == 64, "tiling file header is 64 bytes");
+
+void write_tiling_header(OutBuf& out, int N, uint64_t count, uint64_t first_rank) {
+    TilingFileHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, "TILEBIN", 8);
+    h.version = kTilingFileVersion;
+    h.encoding = kTilingPacked3;
+    h.N = uint64_t(N);
+    h.count = count;
+    h.first_rank = first_rank;
+    h.words = uint32_t(packed_words(N));
+    h.header_checksum = fnv1a(kFnvOffset, &h, offsetof(TilingFileHeader, header_checksum));
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+}
+
+// A tiling dump mapped read-only
+class TilingFile {
+public:
+    TilingFile() {}
+    ~TilingFile() { if (base) ::munmap(const_cast<unsigned char*>(base), size); }
+    TilingFile(const TilingFile&) = delete;
+    TilingFile& operator=(const TilingFile&) = delete;
+
+    // Map FILE and check its header; on failure `error` says why
+    bool open(const std::string& path, std::string& error) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { error = std::strerror(errno); return false; }
+        struct stat st;
+        void* p = MAP_FAILED;
+        if (::fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(TilingFileHeader))
+            p = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) { error = "not a tiling file"; return false; }
+        base = static_cast<const unsigned char*>(p);
+        size = size_t(st.st_size);
+        std::memcpy(&h, base, sizeof(h));
+
+        if (std::memcmp(h.magic, "TILEBIN", 8) != 0) { error = "not a tiling file"; return false; }
+        if (h.version != kTilingFileVersion) { error = "unsupported version " + std::to_string(h.version); return false; }
+        if (h.header_checksum != fnv1a(kFnvOffset, &h, offsetof(TilingFileHeader, header_checksum)) ||
+            h.encoding != kTilingPacked3 || h.N > uint64_t(INT_MAX) || h.words != packed_words(int(h.N))) {
+            error = "corrupt header";
+            return false;
+        }
+        uint64_t record = 8 * uint64_t(h.words);
+        if ((record == 0 ? size != sizeof(h) : (size - sizeof(h)) / record != h.count) ||
+            (record != 0 && (size - sizeof(h)) % record != 0)) {
+            error = "truncated: the header promises " + std::to_string(h.count) + " tilings";
+            return false;
+        }
+        return true;
+    }
+
+    int N() const { return int(h.N); }
+    uint64_t count() const { return h.count; }
+    uint64_t first_rank() const { return h.first_rank; }
+
+    // The packed words of record i, pointing into the mapping
+    const uint64_t* record(uint64_t i) const {
+        return reinterpret_cast<const uint64_t*>(base + sizeof(h)) + i * h.words;
+    }
+
+    // Calls visit(words) for every record in order
+    template <typename Visitor>
+    void for_each(Visitor&& visit) const {
+        for (uint64_t i = 0; i < h.count; i++) visit(record(i));
+    }
+
+private:
+    const unsigned char* base = nullptr;
+    size_t size = 0;
+    TilingFileHeader h;
+};
+
+// Parallel enumeration
+//
+// The search tree is cut after the first `depth` columns: each valid move
+// prefix roots an independent subtree, and subtrees taken in prefix order are
+// exactly enumeration order. Worker threads claim subtrees from a shared
+// counter, so a worker that finishes early simply takes the next one, and each
+// renders into its subtree's own buffer with its own Enumerator and grid. The
+// calling thread writes the buffers strictly in order as they complete, so the
+// output is byte-identical to a single-threaded run.
+//
+// Memory stays bounded. The tree is cut deep enough that a subtree holds
+// about kSubtreeTilings tilings, and a worker may not start a subtree more
+// than kSubtreeWindow per thread ahead of the one being written, so at most
+// that window of rendered subtrees is buffered at once.
+// ---------------------------------------------------------------------------
+const long long kSubtreeTilings = 4096;
+const size_t kMaxSubtrees = size_t(1) << 18;
+const size_t kSubtreeWindow = 4;
+struct TilingPrefix {
+    std::vector<int> moves;
+    int profile;  // profile entering column moves.size()
+};
+
+// All move prefixes of the given depth that can still complete a 2×N tiling
+void collect_prefixes(int N, int depth, std::vector<int>& moves, int profile,
+                      std::vector<TilingPrefix>& out) {
+    int c = moves.size();
+    if (c == depth) {
+        out.push_back({moves, profile});
+        return;
+    }
+    for (int j = 0; j < kMoveCount[profile]; j++) {
+        int next = kMoves[profile][j].next;
+        if (c + 1 == N && next != 0) continue;  // horizontal tile off the right edge
+        moves.push_back(j);
+        collect_prefixes(N, depth, moves, next, out);
+        moves.pop_back();
+    }
+}
+
+// Shallowest cut giving at least `target` subtrees (or the full depth N)
+std::vector<TilingPrefix> split_tiling_tree(int N, size_t target) {
+    std::vector<TilingPrefix> prefixes;
+    std::vector<int> moves;
+    for (int depth = 0;; depth++) {
+        prefixes.clear();
+        collect_prefixes(N, depth, moves, 0, prefixes);
+        if (prefixes.size() >= target || depth == N) return prefixes;
+    }
+}
+
+// Enumerate on `threads` workers; render(grid, index, chunk) appends one
+// tiling to chunk, index being its 1-based position in enumeration order
+template <typename Render>
+void parallel_enumerate(int N, int threads, OutBuf& out, Render render) {
+    auto suffix = suffix_counts<long long>(N);
+    size_t target = size_t(std::min<long long>(suffix[N][0] / kSubtreeTilings, (long long)kMaxSubtrees));
+    std::vector<TilingPrefix> prefixes = split_tiling_tree(N, std::max(target, size_t(32) * threads));
+
+    // Index of each subtree's first tiling, from the suffix counts
+    std::vector<long long> first_index(prefixes.size());
+    long long before = 0;
+    for (size_t i = 0; i < prefixes.size(); i++) {
+        first_index[i] = before;
+        before += suffix[N - prefixes[i].moves.size()][prefixes[i].profile];
+    }
+
+    std::vector<std::string> buffers(prefixes.size());
+    std::vector<char> done(prefixes.size(), 0);
+    std::mutex mutex;
+    std::condition_variable ready, room;
+    std::atomic<size_t> next(0);
+    size_t written = 0;
+    const size_t window = kSubtreeWindow * size_t(threads);
+
+    auto worker = [&]() {
+        Enumerator en(N);
+        for (size_t i; (i = next.fetch_add(1)) < prefixes.size();) {
+            {
+                // The subtree being written is always inside the window, so this never deadlocks
+                std::unique_lock<std::mutex> lock(mutex);
+                room.wait(lock, [&] { return i < written + window; });
+            }
+            std::string chunk;
+            long long index = first_index[i];
+            en.enumerate_prefix(prefixes[i].moves, [&](const Grid& grid) {
+                render(grid, ++index, chunk);
+            });
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers[i].swap(chunk);
+            done[i] = 1;
+            ready.notify_all();
+        }
+        stats_flush();
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back(worker);
+
+    for (size_t i = 0; i < prefixes.size(); i++) {
+        std::string chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&] { return done[i] != 0; });
+            chunk.swap(buffers[i]);
+        }
+        out.put(chunk);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            written = i + 1;
+        }
+        room.notify_all();
+    }
+    for (std::thread& t : pool) t.join();
+}
+
+// CLI
+
+// `enumerate N` without --limit refuses longer floors unless given --all,
+// since even N = 20 means billions of tilings
+const int kMaxUnguardedEnumerateN = 16;
+
+// Look up "--name=value" or "--name value" among the arguments after the
+// subcommand; returns def if the flag is absent
+std::string get_flag(int argc, char* argv[], const std::string& name, const std::string& def) {
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == name && i + 1 < argc) return argv[i + 1];
+        if (arg.compare(0, name.size() + 1, name + "=") == 0) return arg.substr(name.size() + 1);
+    }
+    return def;
+}
+
+// True if the bare switch "--name" appears after the subcommand
+bool has_flag(int argc, char* argv[], const std::string& name) {
+    for (int i = 2; i < argc; i++)
+        if (name == argv[i]) return true;
+    return false;
+}
+
+// Run one counting engine in number type T
+template <typename T>
+T count_with(const std::string& method, long long N) {
+    PhaseTimer timer(kPhaseCounting);
+    if (method == "table") return T((unsigned long long)kSmallCounts[N]);
+    if (method == "dp") return count_dp<T>(N);
+    if (method == "rec") return count_recurrence<T>(N);
+    if (method == "kitamasa") return count_kitamasa<T>(N);
+    return count_matpow<T>(N);
+}
+
+// Exact a_N in decimal: long long while it fits, BigInt beyond. Recurrence
+// counts already in the sequence cache are read from it; a one-off count only
+// grows the cache when it is kept in a file.
+std::string exact_count(const std::string& method, long long N) {
+    SequenceCache& seq = sequence_cache();
+    if (method == "rec" && N >= 0 && N < kSequenceCacheTerms && (N < seq.size() || seq.persistent()))
+        return seq.get(N).to_string();
+    if (N <= kMaxLongLongN) return std::to_string(count_with<long long>(method, N));
+    BigInt value = count_with<BigInt>(method, N);
+    PhaseTimer timer(kPhaseFormat);
+    return value.to_string();
+}
+
+// The engine `count --method=auto` runs: the compile-time table while a_N
+// fits in a long long; for exact big-integer counts the jump-based
+// recurrence, or Kitamasa above kKitamasaExactThreshold; otherwise the DP or,
+// above kMatpowThreshold, Kitamasa
+std::string auto_method(long long N, bool modular) {
+    if (N >= 0 && N <= kMaxLongLongN) return "table";
+    if (N > kMaxLongLongN && !modular) return (N > kKitamasaExactThreshold) ? "kitamasa" : "rec";
+    return (N > kMatpowThreshold) ? "kitamasa" : "dp";
+}
+
+struct CountQuery {
+    long long N;
+    uint64_t P;  // 0 for an exact count
+};
+
+// Answers a batch of queries in input order, as decimal strings. Queries the
+// table file covers are read from it, lane-sized moduli are evaluated kLanes
+// at a time, and the rest go through count_with.
+std::vector<std::string> count_batch(const std::vector<CountQuery>& queries, const TableFile* table = nullptr) {
+    PhaseTimer timer(kPhaseCounting);
+    std::vector<std::string> answers(queries.size());
+    std::vector<size_t> lane_queries;
+    for (size_t i = 0; i < queries.size(); i++) {
+        const CountQuery& q = queries[i];
+        if (table && uint64_t(q.N) < table->terms() && q.P == table->modulus() && table->term(q.N, answers[i]))
+            continue;
+        if (q.P != 0 && q.P < kLaneModulusLimit) {
+            lane_queries.push_back(i);
+        } else if (q.P != 0) {
+            ModInt::set_modulus(q.P);
+            answers[i] = std::to_string(count_with<ModInt>(auto_method(q.N, true), q.N).value());
+        } else if (q.N >= 0 && q.N <= kMaxLongLongN) {
+            answers[i] = std::to_string(kSmallCounts[q.N]);
+        } else if (q.N >= 0 && q.N < kSequenceCacheTerms) {
+            answers[i] = sequence_cache().get(q.N).to_string();  // shared by repeated queries
+        } else {
+            answers[i] = exact_count(auto_method(q.N, false), q.N);
+        }
+    }
+
+    std::sort(lane_queries.begin(), lane_queries.end(),
+              [&](size_t a, size_t b) { return queries[a].N < queries[b].N; });
+    for (size_t g = 0; g < lane_queries.size(); g += kLanes) {
+        // A short last group is padded by repeating its first query
+        LaneModuli mod;
+        uint64_t N[kLanes], out[kLanes];
+        for (int l = 0; l < kLanes; l++) {
+            const CountQuery& q = queries[lane_queries[g + l < lane_queries.size() ? g + l : g]];
+            mod.set(l, uint32_t(q.P));
+            N[l] = uint64_t(q.N);
+        }
+        count_matpow_lanes(mod, N, out);
+        for (int l = 0; l < kLanes && g + l < lane_queries.size(); l++)
+            answers[lane_queries[g + l]] = std::to_string(out[l]);
+    }
+    return answers;
+}
+
+// An exact count shortened to "head...tail (L digits)", from its full decimal form
+std::string digits_summary(const std::string& full, size_t head, size_t tail) {
+    if (full.size() <= head + tail) return full;
+    return full.substr(0, head) + "..." + full.substr(full.size() - tail) +
+           " (" + std::to_string(full.size()) + " digits)";
+}
+
+// The same for a BigInt, converting only the ends when the value is long
+std::string digits_summary(const BigInt& v, size_t head, size_t tail) {
+    std::string lead;
+    long long digits = 0;
+    if (!decimal_head(v, head, lead, digits) || digits <= (long long)(head + tail))
+        return digits_summary(v.to_string(), head, tail);
+    return lead + "..." + (tail > 0 ? decimal_tail(v, tail) : "") +
+           " (" + std::to_string(digits) + " digits)";
+}
+
+// Parse --digits=H,T
+bool parse_digits_flag(const std::string& s, size_t& head, size_t& tail) {
+    size_t comma = s.find(',');
+    if (comma == std::string::npos) return false;
+    std::string h = s.substr(0, comma), t = s.substr(comma + 1);
+    if (h.empty() || t.empty() || h.size() > 7 || t.size() > 7 ||
+        (h + t).find_first_not_of("0123456789") != std::string::npos) return false;
+    head = std::stoul(h);
+    tail = std::stoul(t);
+    return true;
+}
+
+// A modulus as every command spells it: the whole text is digits (no sign,
+// spaces or trailing characters) and the value passes ModInt::valid_modulus.
+// Shared by the command line, count-batch queries and serve requests.
+bool parse_modulus(const std::string& text, uint64_t& p) {
+    const char* end = text.data() + text.size();
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    auto r = std::from_chars(text.data(), end, p);
+    return r.ec == std::errc() && r.ptr == end && ModInt::valid_modulus(p);
+}
+
+// Install the --mod argument as the modulus; reports invalid values
+bool setup_modulus(const std::string& arg) {
+    uint64_t p = 0;
+    if (!parse_modulus(arg, p) || !ModInt::set_modulus(p)) {
+        std::cerr << "Invalid modulus: " << arg << " (expected an odd integer in [3, 2^63))\n";
+        return false;
+    }
+    return true;
+}
+
+// Decimal text of a count or rank in either exact type
+inline std::string to_decimal(long long v) { return std::to_string(v); }
+inline std::string to_decimal(const BigInt& v) { return v.to_string(); }
+
+// Digits only, up to LLONG_MAX; from_chars reports anything larger as out of range
+inline bool parse_decimal(const std::string& s, long long& out) {
+    if (s.empty() || s.find_first_not_of("0123456789") != std::string::npos) return false;
+    auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+inline bool parse_decimal(const std::string& s, BigInt& out) { return BigInt::parse(s, out); }
+
+// `unrank N k` in number type T
+template <typename T>
+int run_unrank(int N, const std::string& k_text, const std::string& format) {
+    auto suffix = suffix_counts<T>(N);
+    T k;
+    if (!parse_decimal(k_text, k) || !(k < suffix[N][0])) {
+        std::cerr << "Rank out of range: " << k_text << " (a 2×" << N << " floor has "
+                  << to_decimal(suffix[N][0]) << " tilings, ranked from 0)\n";
+        return 1;
+    }
+    PackedTiling t = unrank_tiling(N, k, suffix);
+    if (format == "codes") std::cout << encode_tiling(t) << "\n";
+    else print_tiling(t.to_grid(), to_decimal(k + T(1)));
+    return 0;
+}
+
+// `rank <code>` in number type T
+template <typename T>
+void run_rank(const PackedTiling& t) {
+    auto suffix = suffix_counts<T>(t.N);
+    std::cout << "Rank of tiling " << encode_tiling(t) << " on a 2×" << t.N << " floor: "
+              << to_decimal(rank_tiling(t, suffix)) << " (of " << to_decimal(suffix[t.N][0]) << ")\n";
+}
+
+// `enumerate N --offset K --limit L` in number type T: only the requested
+// ranks are visited, so the cost follows the slice rather than a_N
+template <typename T>
+int run_enumerate_slice(int N, const std::string& offset_text, long long limit,
+                        const std::string& format, bool count_only) {
+    auto suffix = suffix_counts<T>(N);
+    const T& total = suffix[N][0];
+    T offset;
+    if (!parse_decimal(offset_text, offset)) {
+        std::cerr << "Invalid offset: " << offset_text << "\n";
+        return 1;
+    }
+
+    // Number of tilings in the slice, clamped to the end of the sequence
+    T size(0);
+    if (offset < total) {
+        T rest = total - offset;
+        size = (limit != LLONG_MAX && T(limit) < rest) ? T(limit) : rest;
+    }
+    if (count_only) {
+        std::cout << to_decimal(size) << "\n";
+        return 0;
+    }
+
+    if (format == "bin") {
+        long long first, count;
+        if (!parse_decimal(to_decimal(offset), first) || !parse_decimal(to_decimal(size), count)) {
+            std::cerr << "--format=bin needs an offset and a slice size below 10^18\n";
+            return 1;
+        }
+        OutBuf out;
+        write_tiling_header(out, N, uint64_t(count), uint64_t(first));
+        std::vector<uint64_t> words(packed_words(N));
+        for_each_tiling_slice(N, offset, limit, [&](const Grid& grid) {
+            pack_tiling(grid, words.data());
+            out.write(reinterpret_cast<const char*>(words.data()), 8 * words.size());
+        });
+        return 0;
+    }
+
+    if (format == "codes") {
+        OutBuf out;
+        std::string line(N, '0');
+        for_each_tiling_slice(N, offset, limit, [&](const Grid& grid) {
+            PackedTiling t(grid);
+            for (int c = 0; c < N; c++) line[c] = char('0' + t.move(c));
+            out.put(line);
+            out.put('\n');
+        });
+        return 0;
+    }
+
+    OutBuf out;
+    if (size == T(0)) {
+        std::string floor = "a 2×" + std::to_string(N) + " floor";
+        if (limit == 0)
+            out.put("No tilings in the slice: the limit is 0 (" + floor + " has " + to_decimal(total) + " tilings)\n");
+        else
+            out.put("No tilings in the slice: #" + to_decimal(offset + T(1)) + " is past the last of the " +
+                    to_decimal(total) + " tilings of " + floor + "\n");
+        return 0;
+    }
+    out.put("Tilings #" + to_decimal(offset + T(1)) + " to #" + to_decimal(offset + size) + " of a 2×" +
+            std::to_string(N) + " floor (" + to_decimal(total) + " total):\n\n");
+    T index = offset;
+    for_each_tiling_slice(N, offset, limit, [&](const Grid& grid) {
+        index = index + T(1);
+        std::string digits = to_decimal(index);
+        print_tiling(grid, digits.data(), digits.size(), out);
+    });
+    return 0;
+}
+
+// `closedform N --precision P`: the sum, its roots and coefficients, and how
+// far the sum at the working precision lies from the exact count
+int run_closedform(long long N, size_t digits, const std::string& format) {
+    size_t limbs = closed_form_limbs(digits, N);
+    ClosedForm cf = closed_form(N, limbs);
+    long long scale;
+    std::string sum_digits = bf_decimal_digits(cf.sum, digits, limbs, scale);
+    std::string sum = decimal_notation(sum_digits, scale, cf.sum.neg);
+    if (format == "value") {
+        std::cout << sum << "\n";
+        return 0;
+    }
+
+    std::cout << "Closed form for a_" << N << " at " << digits << " significant digits:\n\n"
+              << "  a_N = Σ A_i / r_i^(N+1), r_i the roots of x³ − x² − 3x + 1,\n"
+              << "  A_i = (r_i − 1) / (3r_i² − 2r_i − 3)\n\n";
+    for (int i = 0; i < 3; i++) {
+        std::cout << "  r_" << i + 1 << " = " << bf_to_string(cf.roots[i], digits, limbs) << "\n"
+                  << "  A_" << i + 1 << " = " << bf_to_string(cf.coeffs[i], digits, limbs) << "\n";
+    }
+    std::cout << "\nSum:   " << sum << "\n";
+
+    // The exact count is only worth comparing once the sum reaches the units digit
+    if (scale > 0) {
+        std::cout << "The sum stops " << scale << " digits short of the units place; use --precision "
+                  << digits + size_t(scale) + 10 << " or more to round it to a_" << N << "\n";
+        return 0;
+    }
+    BigInt exact = count_with<BigInt>(auto_method(N, false), N);
+    BigFloat err = bf_sub(cf.sum, bf_make(exact, 0, false, limbs), limbs);
+    err.neg = false;
+    // err is the distance of the unrounded sum, not of the digits printed above
+    std::cout << "Error at the working precision of " << 32 * limbs << " bits, before rounding to " << digits
+              << " digits: |Σ − a_" << N << "| = " << bf_to_string(err, 3, limbs, true)
+              << (bf_round_abs(err).is_zero() ? ", rounds to a_" : ", does NOT round to a_") << N << "\n";
+    return 0;
+}
+
+// a/b for counts 0 <= a <= b, b > 0, from the leading 64 bits of each
+inline double count_ratio(long long a, long long b) { return double(a) / double(b); }
+inline double count_ratio(const BigInt& a, const BigInt& b) {
+    auto lead = [](const BigInt& x, long long& e) {
+        const std::vector<uint32_t>& d = x.data();
+        size_t n = d.size();
+        e = (long long)n - (long long)std::min<size_t>(n, 2);
+        if (n == 0) return 0.0;
+        return (n >= 2) ? std::ldexp(double(d[n - 1]), 32) + d[n - 2] : double(d[0]);
+    };
+    long long ea, eb;
+    double ma = lead(a, ea), mb = lead(b, eb);
+    return std::ldexp(ma / mb, int(32 * (ea - eb)));
+}
+
+// `distribution N` in number type T
+template <typename T>
+int run_distribution(int N, int threads, TableFormat format) {
+    std::vector<T> c = composition_counts<T>(N, threads);
+    T total(0);
+    for (const T& v : c) total += v;
+
+    OutBuf out;
+    if (format == TableFormat::Csv) out.put("squares,dominoes,tilings\n");
+    else if (format == TableFormat::Tsv) out.put("squares\tdominoes\ttilings\n");
+    if (format == TableFormat::Text) {
+        // Two passes over the shares keep the variance free of cancellation
+        double mean = 0, variance = 0;
+        for (size_t k = 0; k < c.size(); k++) mean += double(k) * count_ratio(c[k], total);
+        for (size_t k = 0; k < c.size(); k++) variance += (k - mean) * (k - mean) * count_ratio(c[k], total);
+        std::ostringstream os;
+        os << std::setprecision(10) << "Tile composition of the " << to_decimal(total) << " tilings of a 2×" << N
+           << " floor:\n\n"
+           << "  1×1 tiles: mean " << mean << ", variance " << variance << "\n"
+           << "  2×1 tiles: mean " << N - mean / 2 << ", variance " << variance / 4 << "\n\n";
+        out.put(os.str());
+        out.put("  1×1 |   2×1 | tilings\n" + std::string(30, '-') + "\n");
+    }
+    const char sep = (format == TableFormat::Csv) ? ',' : '\t';
+    for (size_t k = 0; k < c.size(); k++) {
+        if (c[k] == T(0)) continue;
+        std::string count = to_decimal(c[k]);
+        char sq[20], dom[20];
+        size_t nsq = std::to_chars(sq, sq + sizeof(sq), k).ptr - sq;
+        size_t ndom = std::to_chars(dom, dom + sizeof(dom), (2 * size_t(N) - k) / 2).ptr - dom;
+        if (format == TableFormat::Text) {
+            out.put_padded(sq, nsq, 5);
+            out.write(" | ", 3);
+            out.put_padded(dom, ndom, 5);
+            out.write(" | ", 3);
+        } else {
+            out.write(sq, nsq);
+            out.put(sep);
+            out.write(dom, ndom);
+            out.put(sep);
+        }
+        out.put(count);
+        out.put('\n');
+    }
+    return 0;
+}
+
+// One row of the recurrence-vs-DP check
+template <typename T>
+bool verify_row(long long i, const T& rec, const T& dp) {
+    PhaseTimer timer(kPhaseFormat);
+    bool match = (rec == dp);
+
+    std::cout << std::setw(5) << i << " | "
+              << std::setw(15) << rec << " | "
+              << std::setw(15) << dp << " | "
+              << (match ? "OK" : "MISMATCH") << "\n";
+    return match;
+}
+
+// Sharded tables
+//
+// `table --shard i/k` splits the rows from..to into k contiguous ranges whose
+// lengths differ by at most one, and prints only the i-th, counted from 1.
+// Each shard seeds its three live terms with its own Kitamasa jump, so shards
+// share no state and can run on different machines. `merge-table` reads the
+// shard outputs in order and checks every row against the recurrence, seeded
+// by an independent jump to the first index. A missing, repeated or wrong row
+// stops the merge, and the message names the shard and the first bad index.
+// That covers a gap or overlap between shards and a wrong seed at a shard
+// boundary. In text format, each shard's header must also match its rows. The
+// merged output is byte-identical to the same table printed in one run.
+// ---------------------------------------------------------------------------
+// Parse "i/k" with 1 <= i <= k
+bool parse_shard(const std::string& s, long long& i, long long& k) {
+    size_t slash = s.find('/');
+    if (slash == std::string::npos) return false;
+    return parse_decimal(s.substr(0, slash), i) && parse_decimal(s.substr(slash + 1), k) && i >= 1 && i <= k;
+}
+
+// Rows of shard i of k over from..to
+void shard_range(long long from, long long to, long long i, long long k, long long& lo, long long& hi) {
+    unsigned __int128 rows = (unsigned __int128)(to - from) + 1;
+    lo = from + (long long)(rows * (i - 1) / k);
+    hi = from + (long long)(rows * i / k) - 1;
+}
+
+// A row index up to 10^18 as printed by `table`
+bool parse_row_index(const char* s, size_t n, long long& out) {
+    auto r = std::from_chars(s, s + n, out);
+    return n > 0 && r.ec == std::errc() && r.ptr == s + n && out >= 0;
+}
+bool parse_row_index(const std::string& s, long long& out) { return parse_row_index(s.data(), s.size(), out); }
+
+// The rows of one `table` output: the index (text formats only) and the
+// value field, as digits or as the binary record
+class TableShardReader {
+public:
+    long long declared_from = -1, declared_to = -1;  // text header range
+    std::string declared_mod;                        // "" without "(mod P)"
+    std::string error;
+
+    bool open(const std::string& path, TableFormat format_, bool modular_) {
+        format = format_;
+        modular = modular_;
+        in.open(path, std::ios::binary);
+        if (!in) { error = "cannot read " + path; return false; }
+        if (format == TableFormat::Binary) return true;
+        std::string line;
+        if (!std::getline(in, line)) return bad("missing table header");
+        if (format == TableFormat::Csv || format == TableFormat::Tsv) {
+            if (line != (format == TableFormat::Csv ? "N,a_N" : "N\ta_N")) return bad("missing table header");
+            return true;
+        }
+        if (std::sscanf(line.c_str(), "Tiling counts a_%lld through a_%lld", &declared_from, &declared_to) != 2)
+            return bad("missing table header");
+        size_t m = line.find(" (mod ");
+        if (m != std::string::npos) declared_mod = line.substr(m + 6, line.find(')', m) - m - 6);
+        // Skip the blank line, the column titles and the rule
+        while (std::getline(in, line) && (line.empty() || line[0] != '-')) {}
+        return true;
+    }
+
+    // False at the end of the file, or on a malformed row (error is set)
+    bool next(long long& index, std::string& value) {
+        if (format == TableFormat::Binary) return next_binary(value);
+        if (!std::getline(in, line)) return false;
+        const char* sep = (format == TableFormat::Csv) ? "," : (format == TableFormat::Tsv) ? "\t" : " | ";
+        size_t at = line.find(sep);
+        if (at == std::string::npos) return bad("malformed row: " + line);
+        size_t i0 = line.find_first_not_of(' ');
+        size_t v0 = line.find_first_not_of(' ', at + std::strlen(sep));
+        if (i0 >= at || v0 == std::string::npos || !parse_row_index(line.data() + i0, at - i0, index))
+            return bad("malformed row: " + line);
+        value.assign(line, v0, std::string::npos);
+        if (value.find_first_not_of("0123456789") != std::string::npos) return bad("malformed row: " + line);
+        return true;
+    }
+
+private:
+    std::ifstream in;
+    std::string line;
+    TableFormat format = TableFormat::Text;
+    bool modular = false;
+
+    bool bad(const std::string& what) {
+        error = what;
+        return false;
+    }
+
+    bool read_bytes(char* p, size_t n) {
+        in.read(p, std::streamsize(n));
+        return size_t(in.gcount()) == n;
+    }
+
+    bool next_binary(std::string& value) {
+        if (in.peek() == std::char_traits<char>::eof()) return false;
+        value.resize(modular ? 8 : 4);
+        if (!read_bytes(&value[0], value.size())) return bad("truncated binary row");
+        if (modular) return true;
+        uint32_t limbs = 0;
+        for (int b = 3; b >= 0; b--) limbs = (limbs << 8) | uint8_t(value[b]);
+        value.resize(4 + size_t(limbs) * 4);
+        if (!read_bytes(&value[4], size_t(limbs) * 4)) return bad("truncated binary row");
+        return true;
+    }
+};
+
+// The three live terms at index i, and each term's value field as `table`
+// prints it: digits in the text formats, the record in binary
+inline void seed_terms(long long i, ModInt t[3]) {
+    auto s = kitamasa_terms<ModInt>(i);
+    std::copy(s.begin(), s.end(), t);
+}
+inline void seed_terms(long long i, BigInt t[3]) {
+    auto s = kitamasa_terms<BigInt>(i);
+    std::copy(s.begin(), s.end(), t);
+}
+inline void seed_terms(long long i, DecimalBig t[3]) {
+    auto s = kitamasa_terms<BigInt>(i);
+    for (int j = 0; j < 3; j++) t[j] = DecimalBig(s[j]);
+}
+
+inline void table_value(const ModInt& v, TableFormat format, std::string& out) {
+    out.clear();
+    if (format == TableFormat::Binary) {
+        for (int b = 0; b < 8; b++) out += char(v.value() >> (8 * b));
+        return;
+    }
+    char tmp[20];
+    out.append(tmp, std::to_chars(tmp, tmp + sizeof(tmp), v.value()).ptr);
+}
+inline void table_value(const BigInt& v, TableFormat, std::string& out) {
+    out.clear();
+    auto put32 = [&out](uint32_t x) {
+        for (int b = 0; b < 4; b++) out += char(x >> (8 * b));
+    };
+    put32(uint32_t(v.size()));
+    for (uint32_t limb : v.data()) put32(limb);
+}
+inline void table_value(const DecimalBig& v, TableFormat, std::string& out) { v.digits(out); }
+
+// Check the shard files in order, then write them out as one table. T is
+// ModInt under --mod, otherwise DecimalBig for text and BigInt for binary.
+// from and to, when not -1, are the range the shards must cover.
+template <typename T>
+int merge_table(const std::vector<std::string>& files, TableFormat format, const std::string& mod,
+                long long from, long long to) {
+    // The text header needs the last index before any row is written
+    long long last = to;
+    if (format == TableFormat::Text) {
+        TableShardReader tail;
+        if (!tail.open(files.back(), format, !mod.empty())) {
+            std::cerr << "Invalid shard " << files.back() << ": " << tail.error << "\n";
+            return 1;
+        }
+        if (to >= 0 && tail.declared_to != to) {
+            std::cerr << "The last shard ends at a_" << tail.declared_to << ", not a_" << to << "\n";
+            return 1;
+        }
+        last = tail.declared_to;
+    }
+
+    // Every shard is checked before anything reaches stdout, so a failed merge
+    // never leaves a truncated table behind: the first pass only verifies, the
+    // second re-reads the shards and writes the rows
+    OutBuf out;
+    TableWriter w{out, format, std::string()};
+    long long first_row = -1, next = -1;
+    auto pass = [&](bool emit) -> bool {
+        T t[3];
+        std::string value, expected;
+        next = (from >= 0) ? from : (format == TableFormat::Binary ? 0 : -1);
+        bool started = false;
+        for (size_t f = 0; f < files.size(); f++) {
+            const std::string& file = files[f];
+            TableShardReader r;
+            if (!r.open(file, format, !mod.empty())) {
+                std::cerr << "Invalid shard " << file << ": " << r.error << "\n";
+                return false;
+            }
+            if (format == TableFormat::Text && r.declared_mod != mod) {
+                std::cerr << "Shard " << file << " is "
+                          << (r.declared_mod.empty() ? "exact" : "mod " + r.declared_mod) << ", expected "
+                          << (mod.empty() ? "exact" : "mod " + mod) << "\n";
+                return false;
+            }
+            long long first_index = -1, index = -1, i = 0;
+            while (r.next(i, value)) {
+                if (format == TableFormat::Binary) i = next;
+                if (!started) {
+                    if (next >= 0 && i != next) {
+                        std::cerr << "Shard " << file << " starts at a_" << i << ", expected a_" << next << "\n";
+                        return false;
+                    }
+                    seed_terms(i, t);
+                    first_row = i;
+                    if (emit) w.header(i, last, mod);
+                    started = true;
+                } else if (i != next) {
+                    std::cerr << "Shard " << file << ": expected a_" << next << ", found a_" << i
+                              << (first_index < 0 ? " (gap or overlap with the previous shard)" : "") << "\n";
+                    return false;
+                }
+                table_value(t[0], format, expected);
+                if (value != expected) {
+                    std::cerr << "Shard " << file << ": a_" << i << " is wrong"
+                              << (first_index < 0 && f > 0 ? " (does not continue the previous shard)" : "") << "\n";
+                    return false;
+                }
+                if (emit) w.term(i, t[0]);
+                recurrence_step(t[0], t[1], t[2]);
+                std::swap(t[0], t[1]);
+                std::swap(t[1], t[2]);
+                if (first_index < 0) first_index = i;
+                index = i;
+                next = i + 1;
+            }
+            if (!r.error.empty()) {
+                std::cerr << "Invalid shard " << file << ": " << r.error << "\n";
+                return false;
+            }
+            if (format == TableFormat::Text && (first_index != r.declared_from || index != r.declared_to)) {
+                std::cerr << "Shard " << file << " declares a_" << r.declared_from << " through a_"
+                          << r.declared_to << " but holds " << (index < 0 ? std::string("no rows") :
+                          "a_" + std::to_string(first_index) + " through a_" + std::to_string(index)) << "\n";
+                return false;
+            }
+        }
+        if (!started || (to >= 0 && next != to + 1)) {
+            std::cerr << "The shards end " << (started ? "at a_" + std::to_string(next - 1) : "with no rows")
+                      << (to >= 0 ? ", expected a_" + std::to_string(to) : std::string()) << "\n";
+            return false;
+        }
+        return true;
+    };
+    if (!pass(false) || !pass(true)) return 1;
+    std::cerr << "Merged a_" << first_row << " through a_" << next - 1 << " from " << files.size()
+              << " shards, every row verified\n";
+    return 0;
+}
+
+// Differential verification
+//
+// `verify N --engines=... --threads T --fail-fast` checks each engine on
+// every a_0..a_N in each number type: long long while the term fits, ModInt
+// under a modulus P, and BigInt. The recurrence is the reference. Three
+// rolling passes, one per type, record a fingerprint of every term: the value
+// itself, the residue, or for BigInt the residue mod the prime 2^61 − 1. The
+// reference vectors (ref_mod, ref_big) therefore take 8 bytes per term, O(N)
+// words in all; the big values themselves are never stored, only the three
+// live terms of each pass.
+//
+// The long long pass uses checked arithmetic and must first overflow at
+// a_(kMaxLongLongN+1), the boundary every exact path relies on. The
+// recurrence in each type is also cross-checked against the others: long
+// long against BigInt, and BigInt reduced mod P against ModInt.
+//
+// The engines then run as independent tasks on T workers. The DP runs as one
+// rolling pass per type, and the O(log N) engines run per index, in chunks.
+// In BigInt, the jump engines are checked at every index up to
+// kVerifyDenseN and at evenly spaced points beyond, ending at N itself. The
+// closed form, costlier still, gets sparser points. Enumeration covers
+// N <= kVerifyEnumN. With --fail-fast, the first mismatch stops every worker.
+// ---------------------------------------------------------------------------
+const char* const kVerifyEngines[] = {"rec", "dp", "matpow", "kitamasa", "table", "enum", "closedform"};
+const long long kVerifyDenseN = 1000;
+const long long kVerifySparsePoints = 64;
+const long long kVerifyClosedFormDenseN = 200;
+const long long kVerifyClosedFormSparsePoints = 16;
+const long long kVerifyEnumN = 12;
+const long long kVerifyChunk = 1024;  // indices per ModInt jump task
+const uint64_t kFingerprintPrime = (uint64_t(1) << 61) - 1;
+
+// v mod 2^61 − 1, one limb at a time from the top
+uint64_t fingerprint(const BigInt& v) {
+    const std::vector<uint32_t>& d = v.data();
+    uint64_t r = 0;
+    for (size_t i = d.size(); i-- > 0;) {
+        unsigned __int128 x = ((unsigned __int128)r << 32) | d[i];
+        r = uint64_t(x & kFingerprintPrime) + uint64_t(x >> 61);
+        if (r >= kFingerprintPrime) r -= kFingerprintPrime;
+    }
+    return r;
+}
+inline uint64_t fingerprint(long long v) { return uint64_t(v) % kFingerprintPrime; }
+
+// v mod P, for the ModInt modulus of the calling thread
+ModInt residue(const BigInt& v) {
+    const std::vector<uint32_t>& d = v.data();
+    ModInt r(0), base(uint64_t(1) << 32);
+    for (size_t i = d.size(); i-- > 0;) r = r * base + ModInt(d[i]);
+    return r;
+}
+
+// 0..min(N, dense), then `sparse` evenly spaced indices up to N
+std::vector<long long> verify_samples(long long N, long long dense, long long sparse) {
+    std::vector<long long> s;
+    for (long long i = 0; i <= std::min(N, dense); i++) s.push_back(i);
+    for (long long j = 1; j <= sparse && N > dense; j++) {
+        long long i = dense + (long long)((unsigned __int128)(N - dense) * j / sparse);
+        if (i > s.back()) s.push_back(i);
+    }
+    return s;
+}
+
+class DifferentialVerifier {
+public:
+    DifferentialVerifier(long long N, const std::vector<std::string>& engines, uint64_t P, bool fail_fast)
+        : N(N), engines(engines), P(P), fail_fast(fail_fast) {
+        // Every track exists before the workers start, so they only read the list
+        for (const char* type : {"long long", "mod P", "bignum"})
+            for (const char* engine : kVerifyEngines) tracks.emplace_back(engine, type);
+    }
+
+    // False if any check failed
+    bool run(int threads) {
+        // The references first: they are what every other task compares with
+        run_tasks({[this] { reference_long_long(); }, [this] { reference_mod(); }, [this] { reference_big(); }},
+                  threads);
+        cross_check_references();
+
+        std::vector<std::function<void()>> tasks;
+        if (wants("dp")) {
+            tasks.push_back([this] { rolling_dp<BigInt>(track("dp", "bignum")); });
+            tasks.push_back([this] { rolling_dp<ModInt>(track("dp", "mod P")); });
+        }
+        // BigInt jump engines, most expensive first
+        std::vector<long long> big = verify_samples(N, kVerifyDenseN, kVerifySparsePoints);
+        std::vector<long long> cf = verify_samples(N, kVerifyClosedFormDenseN, kVerifyClosedFormSparsePoints);
+        for (size_t j = std::max(big.size(), cf.size()); j-- > 0;) {
+            if (j < cf.size() && wants("closedform")) tasks.push_back([this, i = cf[j]] { check_closed_form(i); });
+            if (j >= big.size()) continue;
+            long long i = big[j];
+            if (wants("kitamasa"))
+                tasks.push_back([this, i] { check_big(track("kitamasa", "bignum"), i, count_kitamasa<BigInt>(i)); });
+            if (wants("matpow"))
+                tasks.push_back([this, i] { check_big(track("matpow", "bignum"), i, count_matpow<BigInt>(i)); });
+        }
+        for (long long lo = 0; lo <= N; lo += kVerifyChunk) {
+            long long hi = std::min(N, lo + kVerifyChunk - 1);
+            if (wants("kitamasa")) tasks.push_back([this, lo, hi] { jump_mod<true>(lo, hi); });
+            if (wants("matpow")) tasks.push_back([this, lo, hi] { jump_mod<false>(lo, hi); });
+        }
+        if (wants("enum"))
+            for (long long i = std::min(N, kVerifyEnumN); i >= 0; i--) tasks.push_back([this, i] { check_enum(i); });
+        tasks.push_back([this] { check_long_long(); });
+        run_tasks(tasks, threads);
+        return failures.load() == 0;
+    }
+
+    void print_summary(std::ostream& os) const {
+        os << "\n" << std::left << std::setw(12) << "engine" << std::setw(12) << "type" << std::right
+           << std::setw(12) << "checks" << std::setw(12) << "mismatches" << "\n"
+           << std::string(48, '-') << "\n";
+        for (const Track& t : tracks) {
+            if (t.checks.load() == 0 && t.mismatches.load() == 0) continue;
+            os << std::left << std::setw(12) << t.engine << std::setw(12) << t.type << std::right
+               << std::setw(12) << t.checks.load() << std::setw(12) << t.mismatches.load() << "\n";
+        }
+    }
+
+private:
+    struct Track {
+        const char* engine;
+        const char* type;
+        std::atomic<uint64_t> checks{0}, mismatches{0};
+        Track(const char* engine, const char* type) : engine(engine), type(type) {}
+    };
+
+    long long N;
+    std::vector<std::string> engines;
+    uint64_t P;
+    bool fail_fast;
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> failures{0};
+    std::mutex report_lock;
+    std::deque<Track> tracks;  // one per engine and type, fixed at construction
+
+    std::vector<long long> ref_long_long;  // a_0.. while it fits
+    long long first_overflow = -1;
+    std::vector<uint64_t> ref_mod;         // residues
+    std::vector<uint64_t> ref_big;         // fingerprints
+    std::vector<std::pair<long long, uint64_t>> big_mod;  // (i, a_i mod P) at the sample points
+
+    bool wants(const char* engine) const {
+        return std::find(engines.begin(), engines.end(), engine) != engines.end();
+    }
+
+    Track& track(const char* engine, const char* type) {
+        for (Track& t : tracks)
+            if (!std::strcmp(t.engine, engine) && !std::strcmp(t.type, type)) return t;
+        throw std::logic_error(std::string("no verify track ") + engine + " " + type);
+    }
+
+    // One comparison; got and want are printed on a mismatch
+    bool check(Track& t, long long i, bool ok, const std::string& got, const std::string& want) {
+        t.checks++;
+        if (ok) return true;
+        t.mismatches++;
+        failures++;
+        if (fail_fast) stop = true;
+        std::lock_guard<std::mutex> guard(report_lock);
+        std::cout << "MISMATCH a_" << i << ": " << t.engine << " (" << t.type << ") gives " << got << ", reference "
+                  << want << "\n";
+        return false;
+    }
+
+    void check_big(Track& t, long long i, const BigInt& v) {
+        uint64_t f = fingerprint(v);
+        check(t, i, f == ref_big[i], "fingerprint " + std::to_string(f), "fingerprint " + std::to_string(ref_big[i]));
+    }
+
+    void check_mod(Track& t, long long i, const ModInt& v) {
+        check(t, i, v.value() == ref_mod[i], std::to_string(v.value()), std::to_string(ref_mod[i]));
+    }
+
+    void run_tasks(const std::vector<std::function<void()>>& tasks, int threads) {
+        std::atomic<size_t> next(0);
+        auto worker = [&] {
+            ModInt::set_modulus(P);
+            for (size_t k; !stop.load() && (k = next.fetch_add(1)) < tasks.size();) tasks[k]();
+            stats_flush();
+        };
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+        worker();
+        for (std::thread& t : pool) t.join();
+    }
+
+    // The recurrence in checked long long arithmetic, up to the first overflow
+    void reference_long_long() {
+        long long a0 = 1, a1 = 2, a2 = 7;
+        for (long long i = 0; i <= N; i++) {
+            long long v = (i == 0) ? a0 : (i == 1) ? a1 : a2;
+            if (i >= 3) {
+                long long t, u;
+                if (__builtin_mul_overflow(a2, 3LL, &t) || __builtin_add_overflow(t, a1, &u) ||
+                    __builtin_sub_overflow(u, a0, &v)) {
+                    first_overflow = i;
+                    return;
+                }
+                a0 = a1;
+                a1 = a2;
+                a2 = v;
+            }
+            ref_long_long.push_back(v);
+        }
+    }
+
+    void reference_mod() {
+        PhaseTimer timer(kPhaseCounting);
+        ref_mod.resize(size_t(N) + 1);
+        ModInt t0(1), t1(2), t2(7);
+        for (long long i = 0; i <= N && !stop.load(); i++) {
+            ref_mod[i] = t0.value();
+            recurrence_step(t0, t1, t2);
+            std::swap(t0, t1);
+            std::swap(t1, t2);
+        }
+    }
+
+    void reference_big() {
+        PhaseTimer timer(kPhaseCounting);
+        ref_big.resize(size_t(N) + 1);
+        std::vector<long long> samples = verify_samples(N, kVerifyDenseN, kVerifySparsePoints);
+        size_t s = 0;
+        BigInt t0(1), t1(2), t2(7);
+        for (long long i = 0; i <= N && !stop.load(); i++) {
+            ref_big[i] = fingerprint(t0);
+            if (s < samples.size() && samples[s] == i) big_mod.emplace_back(i, residue(t0).value()), s++;
+            recurrence_step(t0, t1, t2);
+            std::swap(t0, t1);
+            std::swap(t1, t2);
+        }
+    }
+
+    void cross_check_references() {
+        Track& ll = track("rec", "long long");
+        long long expected = std::min(N + 1, kMaxLongLongN + 1);
+        check(ll, expected - 1, (long long)ref_long_long.size() == expected,
+              "overflow at a_" + std::to_string(first_overflow < 0 ? N + 1 : first_overflow),
+              "first overflow at a_" + std::to_string(kMaxLongLongN + 1));
+        Track& big = track("rec", "bignum");
+        for (size_t i = 0; i < ref_long_long.size() && i < ref_big.size(); i++)
+            check(big, i, ref_big[i] == fingerprint(ref_long_long[i]), "fingerprint " + std::to_string(ref_big[i]),
+                  std::to_string(ref_long_long[i]));
+        Track& mod = track("rec", "mod P");
+        for (const auto& m : big_mod)
+            check(mod, m.first, ref_mod[m.first] == m.second, std::to_string(ref_mod[m.first]),
+                  std::to_string(m.second) + " from BigInt");
+    }
 
-    long long a0 = 1, a1 = 2, a2 = 7;
-    for (int i = 3; i <= N; i++) {
-        long long a3 = 3 * a2 + a1 - a0;
-        a0 = a1;
-        a1 = a2;
-        a2 = a3;
+    // Every long long engine while a_i fits
+    void check_long_long() {
+        for (size_t n = 0; n < ref_long_long.size() && !stop.load(); n++) {
+            long long i = (long long)n, want = ref_long_long[n];
+            auto one = [&](const char* engine, long long got) {
+                if (wants(engine))
+                    check(track(engine, "long long"), i, got == want, std::to_string(got), std::to_string(want));
+            };
+            one("rec", count_recurrence<long long>(i));
+            one("dp", count_dp<long long>(i));
+            one("matpow", count_matpow<long long>(i));
+            one("kitamasa", count_kitamasa<long long>(i));
+            one("table", kSmallCounts[i]);
+        }
     }
-    return a2;
-}
 
-// Counting via bitmask DP
-//
-// Process the grid column by column - "profile" is a bitmask of 2 bits
-// representing which cells in the current column are already filled by tiles
-// extending from the previous column.
+    void check_enum(long long i) {
+        if (i >= (long long)ref_long_long.size()) return;
+        long long tilings = 0;
+        for_each_tiling(int(i), [&](const Grid&) { tilings++; });
+        check(track("enum", "long long"), i, tilings == ref_long_long[i], std::to_string(tilings),
+              std::to_string(ref_long_long[i]));
+    }
+
+    void check_closed_form(long long i) {
+        size_t digits = size_t(0.51 * double(i + 1)) + 20;  // a_i has about 0.507(i+1) digits
+        BigInt v = bf_round_abs(closed_form(i, closed_form_limbs(digits, i)).sum);
+        check_big(track("closedform", "bignum"), i, v);
+    }
+
+    // The column DP run once over 0..N, each prefix compared as it appears
+    template <typename T>
+    void rolling_dp(Track& t) {
+        PhaseTimer timer(kPhaseDp);
+        DpLayers<T> dp = dp_layers<T>(4);
+        dp.cur[0] = T(1);
+        for (long long i = 0; i <= N && !stop.load(); i++) {
+            if (i > 0) {
+                dp_column(dp.cur, dp.nxt, false);
+                dp.swap();
+            }
+            compare_rolling(t, i, dp.cur[0]);
+        }
+    }
+    void compare_rolling(Track& t, long long i, const BigInt& v) { check_big(t, i, v); }
+    void compare_rolling(Track& t, long long i, const ModInt& v) { check_mod(t, i, v); }
+
+    template <bool Kitamasa>
+    void jump_mod(long long lo, long long hi) {
+        Track& t = track(Kitamasa ? "kitamasa" : "matpow", "mod P");
+        for (long long i = lo; i <= hi && !stop.load(); i++)
+            check_mod(t, i, Kitamasa ? count_kitamasa<ModInt>(i) : count_matpow<ModInt>(i));
+    }
+};
+
+// Server mode
 //
-// At each column, we try all ways to fill the empty cells using:
-//   - 1×1 tiles (fill one cell)
-//   - Vertical 2×1 tiles (fill both cells in this column)
-//   - Horizontal 2×1 tiles (extend into the next column, setting bits in the
-//     next profile)
+// `serve` answers newline-delimited requests on stdin, or with --socket PATH
+// on a Unix socket, so a stream of small queries pays the process startup
+// once. A request is a command line without the program name:
+//   count N [--mod P] [--rows M] [--method=...]
+//   unrank N k
+//   rank <code>
+//   sample N count [--seed S]
+// and each gets exactly one response line, in order: the count, the tiling
+// code, the rank, the sampled codes separated by spaces, or "error: ...".
 //
-// Profile bits: bit 0 = top row, bit 1 = bottom row.
+// Everything a request builds stays warm for the next: exact terms in the
+// sequence cache, transfer matrices, and per-N suffix tables and samplers.
+// Input is read in blocks, and the answers to every complete request in a
+// block go into one buffer that is written when the block is used up, so a
+// pipelined client gets its answers in large writes. Socket clients are
+// multiplexed with poll(2) on one thread, since the modulus of ModInt is
+// process-wide.
 // ---------------------------------------------------------------------------
-long long count_dp(int N) {
-    if (N == 0) return 1;
+class TilingServer {
+public:
+    TilingServer() : rng(std::random_device{}()) {}
 
-    // dp[profile] = number of ways to fill columns 0..col-1 s.t.
-    // column col has the given profile of pre-filled cells.
-    std::vector<long long> dp(4, 0);
-    dp[0] = 1; // column 0 starts empty
+    // Answer one request line, appending one response line to out. The token,
+    // argv and answer buffers are members, so a long session of requests whose
+    // answers fit in 64 bits runs without heap allocations once warm.
+    void handle(const std::string& line, OutBuf& out) { handle(line.data(), line.size(), out); }
 
-    for (int col = 0; col < N; col++) {
-        std::vector<long long> ndp(4, 0);
-
-        for (int mask = 0; mask < 4; mask++) {
-            if (dp[mask] == 0) continue;
-
-            bool top_filled = (mask >> 0) & 1;
-            bool bot_filled = (mask >> 1) & 1;
-
-            if (top_filled && bot_filled) {
-                // Both cells pre-filled; nothing to place, next profile = 0
-                ndp[0] += dp[mask];
-            } else if (top_filled && !bot_filled) {
-                // Only bottom cell is empty
-                // Option 1: place 1×1 in bottom
-                ndp[0] += dp[mask];
-                // Option 2: place horizontal 2×1 in bottom (extends right)
-                if (col + 1 < N)
-                    ndp[2] += dp[mask]; // bit 1 set in next column
-            } else if (!top_filled && bot_filled) {
-                // Only top cell is empty
-                // Option 1: place 1×1 in top
-                ndp[0] += dp[mask];
-                // Option 2: place horizontal 2×1 in top (extends right)
-                if (col + 1 < N)
-                    ndp[1] += dp[mask]; // bit 0 set in next column
-            } else {
-                // Both cells empty
-                // Option 1: vertical 2×1 covering both
-                ndp[0] += dp[mask];
-                // Option 2: two 1×1 tiles
-                ndp[0] += dp[mask];
-                // Option 3: 1×1 top + horizontal bottom
-                if (col + 1 < N)
-                    ndp[2] += dp[mask];
-                // Option 4: horizontal top + 1×1 bottom
-                if (col + 1 < N)
-                    ndp[1] += dp[mask];
-                // Option 5: horizontal top + horizontal bottom
-                if (col + 1 < N)
-                    ndp[3] += dp[mask];
+    void handle(const char* line, size_t size, OutBuf& out) {
+        // argv as main would see it: args[0] stands in for the program name
+        size_t n = 1;
+        if (words.empty()) words.push_back("serve");
+        for (size_t i = 0; i < size;) {
+            while (i < size && std::isspace((unsigned char)line[i])) i++;
+            size_t j = i;
+            while (j < size && !std::isspace((unsigned char)line[j])) j++;
+            if (j > i) {
+                if (n == words.size()) words.emplace_back();
+                words[n++].assign(line + i, j - i);
             }
+            i = j;
         }
+        if (n < 2) return;  // blank line
+        argv.clear();
+        for (size_t k = 0; k < n; k++) argv.push_back(&words[k][0]);
 
-        dp = ndp;
+        reply.clear();
+        reason.clear();
+        try {
+            if (!answer_request(int(argv.size()), argv.data(), reply, reason)) reply = "error: " + reason;
+        } catch (const std::exception&) {
+            reply = "error: invalid request: " + std::string(line, size);
+        }
+        out.put(reply);
+        out.put('\n');
     }
 
-    return dp[0]; 
-}
+private:
+    template <typename T>
+    using SuffixTable = std::vector<std::array<T, 4>>;
 
-// Enumeration via backtracking
-//
-// Scan cells left-to-right, top-to-bottom. At each empty cell, try:
-//   1. Place a 1×1 tile
-//   2. Place a horizontal 2×1 tile (if the cell to the right is empty)
-//   3. Place a vertical 2×1 tile (if the cell below is empty)
-// and record
-struct Enumerator {
-    int N;
-    // grid[row][col] stores the tile label (A, B, C, ...)
-    std::vector<std::vector<char>> grid;
-    std::vector<std::vector<std::vector<char>>> results;
-    char next_label;
+    // Warm tables are kept for this many distinct N of each kind
+    static const size_t kMaxEntries = 64;
 
-    Enumerator(int n) : N(n), grid(2, std::vector<char>(n, '.')), next_label('A') {}
+    // Largest sample reply, count · (N + 1) characters, one request may ask for
+    static const long long kMaxSampleReply = 1LL << 26;
 
-    // Find the next empty cell scanning left-to-right, top-to-bottom
-    bool find_next_empty(int& row, int& col) {
-        for (int c = 0; c < N; c++) {
-            for (int r = 0; r < 2; r++) {
-                if (grid[r][c] == '.') {
-                    row = r;
-                    col = c;
-                    return true;
-                }
-            }
+    std::mt19937_64 rng;
+    std::vector<std::string> words;
+    std::vector<char*> argv;
+    std::string reply, reason;
+    std::vector<uint64_t> sample_words;
+    std::map<int, SuffixTable<long long>> small_suffix;
+    std::map<int, SuffixTable<BigInt>> big_suffix;
+    std::map<int, std::unique_ptr<TilingSampler>> samplers;
+
+    template <typename Map>
+    static void make_room(Map& m) {
+        if (m.size() >= kMaxEntries) m.clear();
+    }
+
+    std::map<int, SuffixTable<long long>>& suffix_tables(long long) { return small_suffix; }
+    std::map<int, SuffixTable<BigInt>>& suffix_tables(const BigInt&) { return big_suffix; }
+
+    template <typename T>
+    const SuffixTable<T>& suffix(int N) {
+        auto& tables = suffix_tables(T());
+        auto it = tables.find(N);
+        if (it != tables.end()) return it->second;
+        make_room(tables);
+        return tables.emplace(N, suffix_counts<T>(N)).first->second;
+    }
+
+    template <typename T>
+    bool unrank(int N, const std::string& k_text, std::string& answer, std::string& error) {
+        const SuffixTable<T>& s = suffix<T>(N);
+        T k;
+        if (!parse_decimal(k_text, k) || !(k < s[N][0])) {
+            error = "rank out of range: " + k_text;
+            return false;
         }
-        return false;
+        answer = encode_tiling(unrank_tiling(N, k, s));
+        return true;
     }
 
-    void solve() {
-        int row, col;
-        if (!find_next_empty(row, col)) {
-            // All cells filled — record this tiling
-            results.push_back(grid);
-            return;
+    template <typename T>
+    std::string rank(const PackedTiling& t) {
+        return to_decimal(rank_tiling(t, suffix<T>(t.N)));
+    }
+
+    // Decimal digits of v appended in place, reusing the answer's capacity
+    static void append_decimal(std::string& out, uint64_t v) {
+        char tmp[20];
+        out.append(tmp, std::to_chars(tmp, tmp + sizeof(tmp), v).ptr);
+    }
+
+    static bool parse_size(const char* s, long long& out, std::string& error) {
+        if (!parse_decimal(s, out)) {
+            error = std::string("invalid number: ") + s;
+            return false;
         }
+        return true;
+    }
 
-        char label = next_label++;
+    static bool fits_int(long long N, std::string& error) {
+        if (N <= INT_MAX) return true;
+        error = "N too large: " + std::to_string(N);
+        return false;
+    }
 
-        // Option 1: place a 1×1 tile
-        grid[row][col] = label;
-        solve();
-        grid[row][col] = '.';
+    bool answer_request(int argc, char* argv[], std::string& answer, std::string& error) {
+        std::string cmd = argv[1];
+        long long N = 0;
+        if (cmd == "count") {
+            if (argc < 3) {
+                error = "usage: count N [--mod P] [--rows M] [--method=...]";
+                return false;
+            }
+            if (!parse_size(argv[2], N, error)) return false;
+            std::string method = get_flag(argc, argv, "--method", "auto");
+            std::string mod = get_flag(argc, argv, "--mod", "");
+            long long rows = 2;
+            if (!parse_size(get_flag(argc, argv, "--rows", "2").c_str(), rows, error)) return false;
+            if (!mod.empty()) {
+                uint64_t p = 0;
+                if (!parse_modulus(mod, p) || !ModInt::set_modulus(p)) {
+                    error = "invalid modulus: " + mod;
+                    return false;
+                }
+            }
+            if (rows < 1 || rows > kMaxRows) {
+                error = "invalid row count: " + std::to_string(rows);
+                return false;
+            }
+            if (rows != 2) {
+                if (mod.empty() && !exact_board_in_reach(int(rows), N)) {
+                    error = "exact " + std::to_string(rows) + "×" + std::to_string(N) +
+                            " count too expensive; use --mod P";
+                    return false;
+                }
+                if (mod.empty())
+                    answer = exact_board_count(int(rows), N);
+                else
+                    append_decimal(answer, count_rows<ModInt>(int(rows), N).value());
+                return true;
+            }
+            if (method != "auto" && method != "dp" && method != "rec" && method != "matpow" && method != "kitamasa" &&
+                method != "table") {
+                error = "unknown method: " + method;
+                return false;
+            }
+            if (method == "table" && N > kMaxLongLongN) {
+                error = "method table only covers N = 0.." + std::to_string(kMaxLongLongN);
+                return false;
+            }
+            if (!mod.empty()) {
+                if (method == "auto") method = auto_method(N, true);
+                append_decimal(answer, count_with<ModInt>(method, N).value());
+            } else if ((method == "auto" || method == "table") && N <= kMaxLongLongN) {
+                append_decimal(answer, uint64_t(kSmallCounts[N]));
+            } else if ((method == "auto" || method == "rec") && N < kSequenceCacheTerms) {
+                answer = sequence_cache().get(N).to_string();
+            } else {
+                answer = exact_count(method == "auto" ? auto_method(N, false) : method, N);
+            }
+            return true;
+        }
 
-        // Option 2: place a horizontal 2×1 tile (extends right)
-        if (col + 1 < N && grid[row][col + 1] == '.') {
-            grid[row][col] = label;
-            grid[row][col + 1] = label;
-            solve();
-            grid[row][col] = '.';
-            grid[row][col + 1] = '.';
+        if (cmd == "unrank") {
+            if (argc < 4) {
+                error = "usage: unrank N k";
+                return false;
+            }
+            if (!parse_size(argv[2], N, error) || !fits_int(N, error)) return false;
+            return (N <= kMaxLongLongN) ? unrank<long long>(int(N), argv[3], answer, error)
+                                        : unrank<BigInt>(int(N), argv[3], answer, error);
         }
 
-        // Option 3: place a vertical 2×1 tile (extends down)
-        if (row + 1 < 2 && grid[row + 1][col] == '.') {
-            grid[row][col] = label;
-            grid[row + 1][col] = label;
-            solve();
-            grid[row][col] = '.';
-            grid[row + 1][col] = '.';
+        if (cmd == "rank") {
+            PackedTiling t;
+            if (argc < 3 || !decode_tiling(argv[2], t)) {
+                error = (argc < 3) ? "usage: rank <code>" : std::string("invalid tiling code: ") + argv[2];
+                return false;
+            }
+            answer = (t.N <= kMaxLongLongN) ? rank<long long>(t) : rank<BigInt>(t);
+            return true;
         }
 
-        next_label--;
-    }
+        if (cmd == "sample") {
+            long long samples = 0;
+            if (argc < 4) {
+                error = "usage: sample N count [--seed S]";
+                return false;
+            }
+            if (!parse_size(argv[2], N, error) || !fits_int(N, error) || !parse_size(argv[3], samples, error))
+                return false;
+            if (samples > kMaxSampleReply / (N + 1)) {
+                error = "sample too large: " + std::to_string(samples) + " tilings of length " + std::to_string(N) +
+                        " exceed " + std::to_string(kMaxSampleReply) + " characters";
+                return false;
+            }
+            auto it = samplers.find(int(N));
+            if (it == samplers.end()) {
+                make_room(samplers);
+                it = samplers.emplace(int(N), std::unique_ptr<TilingSampler>(new TilingSampler(int(N)))).first;
+            }
+            std::string seed = get_flag(argc, argv, "--seed", "");
+            std::mt19937_64 seeded(seed.empty() ? 0 : std::stoull(seed));
+            std::mt19937_64& r = seed.empty() ? rng : seeded;
+            sample_words.resize(packed_words(int(N)));
+            answer.reserve(size_t(samples) * size_t(N + 1));
+            for (long long i = 0; i < samples; i++) {
+                it->second->sample(r, sample_words.data());
+                if (i > 0) answer += ' ';
+                for (int c = 0; c < N; c++) answer += char('0' + packed_move(sample_words.data(), c));
+            }
+            return true;
+        }
 
-    void enumerate() {
-        results.clear();
-        next_label = 'A';
-        solve();
+        error = "unknown command: " + cmd + " (expected count, unrank, rank or sample)";
+        return false;
     }
 };
 
-// Print a single tiling as ASCII art with numeric labels and merged cells
-void print_tiling(const std::vector<std::vector<char>>& grid, int index) {
-    int N = grid[0].size();
-    std::cout << "Tiling #" << index << ":\n";
+// Answer every complete line in `pending`, keeping a trailing partial line
+void serve_lines(TilingServer& server, std::string& pending, OutBuf& out) {
+    size_t start = 0;
+    for (size_t nl; (nl = pending.find('\n', start)) != std::string::npos; start = nl + 1)
+        server.handle(pending.data() + start, nl - start, out);
+    pending.erase(0, start);
+}
 
-    // Determine tile size for each label: 1 for 1×1, 2 for 2×1
-    std::map<char, int> tile_size;
-    for (int c = 0; c < N; c++) {
-        for (int r = 0; r < 2; r++) {
-            char ch = grid[r][c];
-            if (tile_size.find(ch) == tile_size.end())
-                tile_size[ch] = 1;
-            else
-                tile_size[ch] = 2;
-        }
-    }
-
-    // Helper: print a content row with merged cells for horizontal tiles
-    auto print_row = [&](int r) {
-        std::cout << "|";
-        int c = 0;
-        while (c < N) {
-            std::string s = std::to_string(tile_size[grid[r][c]]);
-            if (c + 1 < N && grid[r][c] == grid[r][c + 1]) {
-                // Horizontal 2×1 tile: merged cell is 7 chars wide
-                int padding = 7 - (int)s.size();
-                std::cout << std::string(padding / 2, ' ') << s
-                          << std::string(padding - padding / 2, ' ') << "|";
-                c += 2;
-            } else {
-                // Single cell: 3 chars wide
-                int padding = 3 - (int)s.size();
-                std::cout << std::string(padding / 2, ' ') << s
-                          << std::string(padding - padding / 2, ' ') << "|";
-                c++;
-            }
+// Serve one input stream until end of file; false on a read error
+bool serve_stream(TilingServer& server, int in_fd, int out_fd) {
+    OutBuf out(out_fd);
+    std::string pending;
+    std::vector<char> block(size_t(1) << 16);
+    for (;;) {
+        ssize_t n = ::read(in_fd, block.data(), block.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            if (!pending.empty()) server.handle(pending, out);
+            return n == 0;
+        }
+        pending.append(block.data(), size_t(n));
+        serve_lines(server, pending, out);
+        out.flush();
+    }
+}
+
+// Accept clients on a Unix socket and serve them until killed
+//
+// Every client socket is non-blocking. Replies collect in the client's
+// outgoing buffer and go out when poll reports POLLOUT, so a client that
+// stops reading stalls only itself. Once kMaxClientBacklog reply bytes are
+// waiting, the server stops answering and reading that client until they
+// drain; a request line longer than kMaxRequestLine disconnects it.
+const size_t kMaxClientBacklog = size_t(1) << 20;
+const size_t kMaxRequestLine = size_t(1) << 24;
+
+int serve_socket(TilingServer& server, const std::string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << path << "\n";
+        return 1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ::unlink(path.c_str());  // a socket left over from an earlier run
+    if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listener, 64) != 0) {
+        std::cerr << "Cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);  // a client that hangs up must not stop the server
+
+    struct Client {
+        int fd;
+        std::string pending;   // request bytes not yet answered
+        std::string outgoing;  // reply bytes from `sent` on are not yet written
+        size_t sent = 0;
+        bool eof = false;      // the client has sent its last request
+        size_t backlog() const { return outgoing.size() - sent; }
+    };
+    // Answer complete lines while the backlog allows, and after end of file
+    // the trailing partial line too
+    auto answer = [&server](Client& c) {
+        OutBuf out(c.outgoing);
+        size_t start = 0;
+        for (size_t nl; c.backlog() < kMaxClientBacklog && (nl = c.pending.find('\n', start)) != std::string::npos;
+             start = nl + 1) {
+            server.handle(c.pending.data() + start, nl - start, out);
+            out.flush();
         }
-        std::cout << "\n";
+        c.pending.erase(0, start);
+        if (c.eof && !c.pending.empty() && c.pending.find('\n') == std::string::npos &&
+            c.backlog() < kMaxClientBacklog) {
+            server.handle(c.pending, out);
+            c.pending.clear();
+        }
+    };
+    // Write what the socket takes now; false if the client is gone
+    auto drain = [](Client& c) {
+        while (c.backlog() > 0) {
+            ssize_t w = ::write(c.fd, c.outgoing.data() + c.sent, c.backlog());
+            if (w < 0 && errno == EINTR) continue;
+            if (w < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+            c.sent += size_t(w);
+        }
+        c.outgoing.clear();
+        c.sent = 0;
+        return true;
     };
 
-    // Helper: print a border row
-    // type: 0=top, 1=middle, 2=bottom
-    auto print_border = [&](int type) {
-        std::cout << "+";
-        for (int c = 0; c < N; c++) {
-            // Segment: "---" unless middle border with vertical tile
-            if (type == 1 && grid[0][c] == grid[1][c])
-                std::cout << "   ";
-            else
-                std::cout << "---";
-
-            // Junction after this column
-            if (c + 1 < N) {
-                if (type == 0 && grid[0][c] == grid[0][c + 1])
-                    std::cout << "-";  // top row horizontal span
-                else if (type == 2 && grid[1][c] == grid[1][c + 1])
-                    std::cout << "-";  // bottom row horizontal span
-                else
-                    std::cout << "+";
-            } else {
-                std::cout << "+";
+    std::vector<Client> clients;
+    std::vector<char> block(size_t(1) << 16);
+    for (;;) {
+        std::vector<pollfd> fds(1, pollfd{listener, POLLIN, 0});
+        for (const Client& c : clients) {
+            short events = 0;
+            if (!c.eof && c.backlog() < kMaxClientBacklog) events |= POLLIN;
+            if (c.backlog() > 0) events |= POLLOUT;
+            fds.push_back(pollfd{c.fd, events, 0});
+        }
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "poll: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        for (size_t i = fds.size(); i-- > 1;) {
+            Client& c = clients[i - 1];
+            bool alive = true;
+            if (fds[i].revents & POLLIN) {
+                ssize_t n = ::read(c.fd, block.data(), block.size());
+                if (n > 0) c.pending.append(block.data(), size_t(n));
+                else if (n == 0) c.eof = true;
+                else alive = errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+            } else if (fds[i].revents & (POLLHUP | POLLERR)) {
+                alive = false;  // gone, with nothing left to read
+            }
+            if (alive) {
+                answer(c);
+                alive = drain(c) && c.pending.size() <= kMaxRequestLine &&
+                        !(c.eof && c.pending.empty() && c.backlog() == 0);
+            }
+            if (!alive) {
+                ::close(c.fd);
+                clients.erase(clients.begin() + (i - 1));
             }
         }
-        std::cout << "\n";
-    };
+        if (fds[0].revents & POLLIN) {
+            int fd = ::accept(listener, nullptr, nullptr);
+            if (fd >= 0) {
+                ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+                clients.push_back(Client{fd, std::string(), std::string()});
+            }
+        }
+    }
+}
 
-    print_border(0);  // top border
-    print_row(0);     // top row
-    print_border(1);  // middle border
-    print_row(1);     // bottom row
-    print_border(2);  // bottom border
-    std::cout << "\n";
+// Benchmarks
+//
+// `bench` times every counting engine in each number type, the batch kernel,
+// enumeration, sampling and rendering over sweeps of N, and prints one JSON
+// document: per benchmark the iterations run, wall time per operation,
+// allocations and bytes allocated per operation (from the operator new
+// counters), and throughput in the benchmark's own unit. Each operation runs
+// once as a warm-up, then in doubling batches until --min-time seconds have
+// passed. Comparing engines at the same N locates the crossovers that
+// auto_method encodes.
+// ---------------------------------------------------------------------------
+// Keep the compiler from discarding a benchmarked result
+template <typename T>
+inline void bench_keep(const T& v) {
+#if defined(__GNUC__)
+    asm volatile("" : : "r"(&v) : "memory");
+#else
+    static const volatile void* sink;
+    sink = &v;
+#endif
+}
+
+struct BenchResult {
+    std::string name;
+    long long N;
+    uint64_t iterations;
+    double ns_per_op, allocs_per_op, bytes_per_op, items_per_second;
+    std::string unit;
+};
+
+class BenchRunner {
+public:
+    BenchRunner(double min_seconds, const std::string& filter) : min_seconds(min_seconds), filter(filter) {}
+
+    // Time op(), which handles `items` units of work per call
+    template <typename Op>
+    void run(const std::string& name, long long N, double items, const std::string& unit, Op&& op) {
+        if (name.find(filter) == std::string::npos) return;
+        typedef std::chrono::steady_clock Clock;
+        uint64_t iterations = 0, batch = 1;
+        uint64_t allocs = g_allocations.load(), bytes = g_allocated_bytes.load();
+        Clock::time_point start = Clock::now();
+        op();
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (elapsed < min_seconds) {
+            // The first call was only a warm-up; start measuring afresh
+            allocs = g_allocations.load();
+            bytes = g_allocated_bytes.load();
+            start = Clock::now();
+            do {
+                for (uint64_t i = 0; i < batch; i++) op();
+                iterations += batch;
+                batch *= 2;
+                elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            } while (elapsed < min_seconds);
+        } else {
+            iterations = 1;
+        }
+        double n = double(iterations);
+        results.push_back({name, N, iterations, elapsed * 1e9 / n, (g_allocations.load() - allocs) / n,
+                           (g_allocated_bytes.load() - bytes) / n, items * n / elapsed, unit});
+    }
+
+    void print(std::ostream& os) const {
+        os << "{\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult& r = results[i];
+            os << "    {\"name\": \"" << r.name << "\", \"N\": " << r.N << ", \"iterations\": " << r.iterations
+               << std::fixed << std::setprecision(1) << ", \"ns_per_op\": " << r.ns_per_op
+               << std::setprecision(2) << ", \"allocs_per_op\": " << r.allocs_per_op
+               << ", \"alloc_bytes_per_op\": " << r.bytes_per_op
+               << ", \"" << r.unit << "_per_second\": " << r.items_per_second << "}"
+               << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        os << "  ]\n}\n";
+    }
+
+private:
+    double min_seconds;
+    std::string filter;
+    std::vector<BenchResult> results;
+};
+
+template <typename T>
+void bench_engines(BenchRunner& b, const std::string& type, const std::vector<long long>& recurrence,
+                   const std::vector<long long>& dp, const std::vector<long long>& logarithmic) {
+    for (long long N : recurrence)
+        b.run("count_recurrence<" + type + ">", N, 1, "counts", [N] { bench_keep(count_recurrence<T>(N)); });
+    for (long long N : dp) b.run("count_dp<" + type + ">", N, 1, "counts", [N] { bench_keep(count_dp<T>(N)); });
+    for (long long N : logarithmic) {
+        b.run("count_matpow<" + type + ">", N, 1, "counts", [N] { bench_keep(count_matpow<T>(N)); });
+        b.run("count_kitamasa<" + type + ">", N, 1, "counts", [N] { bench_keep(count_kitamasa<T>(N)); });
+    }
+}
+
+void run_benchmarks(BenchRunner& b) {
+    bench_engines<long long>(b, "long long", {10, 37}, {10, 37}, {10, 37});
+    ModInt::set_modulus(998244353);
+    bench_engines<ModInt>(b, "ModInt", {64, 1000, 100000}, {64, 1000, 100000},
+                          {64, 1000, 1000000, 1000000000000000000LL});
+    bench_engines<BigInt>(b, "BigInt", {1000, 10000, 100000}, {1000, 10000}, {1000, 10000, 100000, 1000000});
+
+    for (long long N : {1000LL, 10000LL}) {
+        b.run("count_board<ModInt>/rows=8", N, 1, "counts", [N] { bench_keep(count_board<ModInt>(8, N)); });
+    }
+    {
+        // One full lane group of lane-sized moduli
+        std::vector<CountQuery> queries;
+        for (int i = 0; i < kLanes; i++) queries.push_back({(1LL << 60) + i, uint64_t(1000000007 - 2 * i) % kLaneModulusLimit | 1});
+        b.run("count_batch/lanes", 1LL << 60, kLanes, "queries", [&] { bench_keep(count_batch(queries)); });
+    }
+
+    for (int N : {8, 12, 14}) {
+        double tilings = double(count_dp(N));
+        b.run("Enumerator::enumerate", N, tilings, "tilings", [N] {
+            long long n = 0;
+            for_each_tiling(N, [&](const Grid&) { n++; });
+            bench_keep(n);
+        });
+    }
+    for (int N : {100, 1000}) {
+        TilingSampler sampler(N);
+        std::mt19937_64 rng(1);
+        std::vector<uint64_t> words(packed_words(N));
+        b.run("TilingSampler::sample", N, 1, "tilings", [&] {
+            sampler.sample(rng, words.data());
+            bench_keep(words[0]);
+        });
+    }
+    for (int N : {10, 100}) {
+        Grid grid(N);
+        for (int c = 0; c < N; c++) grid[0][c] = grid[1][c] = char('A' + c % 26);  // verticals
+        std::vector<char> text(tiling_text_size(N, 1));
+        b.run("render_tiling", N, double(text.size()), "bytes", [&] {
+            bench_keep(render_tiling(grid, "1", 1, text.data()));
+            bench_keep(text[0]);
+        });
+    }
 }
 
-// CLI
 void print_usage(const char* prog) {
     std::cout << "Usage:\n"
               << "  " << prog << " count <N>       Count tilings for a 2×N floor\n"
+              << "        [--method=auto|dp|rec|matpow|kitamasa] [--mod P] [--rows M] [--transfer-cache DIR] [--digits=H,T]\n"
+              << "        (exact counts with --rows grow as N²·M²·2^M and stop at about 100 s: N ≈ 2,250 at M = 12)\n"
+              << "        [--table-file FILE]  (the payload is not checksummed per lookup; run check-table first)\n"
+              << "  " << prog << " count-batch [file]  Answer one \"N [P]\" query per line (stdin if no file)\n"
+              << "        [--mod P] [--table-file FILE]\n"
               << "  " << prog << " enumerate <N>   Print all tilings as ASCII grids\n"
+              << "        [--format=ascii|codes|bin] [--threads T]\n"
+              << "        [--offset K] [--limit L] [--count-only] [--all]\n"
+              << "  " << prog << " read-tilings <file>  Read an `enumerate --format=bin` dump\n"
+              << "        [--format=codes|ascii|summary]\n"
               << "  " << prog << " verify <N>      Verify recurrence vs DP for N=0..N\n"
+              << "        [--engines=rec,dp,matpow,kitamasa,table,enum,closedform] [--threads T] [--mod P] [--fail-fast]\n"
+              << "  " << prog << " unrank <N> <k>  Print the tiling of rank k (0-based, enumeration order)\n"
+              << "        [--format=ascii|codes]\n"
+              << "  " << prog << " rank <code>     Rank of a tiling given as a move code\n"
+              << "  " << prog << " sample <N> <count>  Print uniformly random tilings\n"
+              << "        [--seed S] [--format=codes|ascii|summary]\n"
+              << "  " << prog << " bench           Time every engine over N sweeps; JSON on stdout\n"
+              << "        [--filter NAME] [--min-time SECONDS]\n"
+              << "  " << prog << " serve           Answer one request per line (count, unrank, rank, sample)\n"
+              << "        [--socket PATH]\n"
+              << "  " << prog << " build-table <N> <file>  Write a_0..a_N to a file for --table-file\n"
+              << "        [--mod P]\n"
+              << "  " << prog << " check-table <file>  Verify a table file's checksum and last term\n"
+              << "  " << prog << " distribution <N>  Histogram of 1×1 tiles over all 2×N tilings, with mean and variance\n"
+              << "        [--threads T] [--format=text|csv|tsv]\n"
+              << "  " << prog << " closedform <N>  Evaluate a_N from the roots of x³ − x² − 3x + 1\n"
+              << "        [--precision P] [--format=text|value]\n"
               << "  " << prog << " lego            Solve the LEGO problem (2×10 floor)\n"
-              << "  " << prog << " table <N>       Print a_0 through a_N\n";
+              << "  " << prog << " table <N>       Print a_0 through a_N (or a_A..a_B)\n"
+              << "        [--from A] [--to B] [--shard i/k] [--mod P] [--format=text|csv|tsv|binary]\n"
+              << "  " << prog << " merge-table <shard>...  Check `table --shard` outputs in order and join them\n"
+              << "        [--from A] [--to B] [--mod P] [--format=text|csv|tsv|binary]\n"
+              << "  Any command: [--sequence-cache FILE]  Keep the exact terms computed in FILE between runs\n"
+              << "               [--stats]  Report counters and per-phase times on stderr\n";
 }
 
 int main(int argc, char* argv[]) {
@@ -261,33 +4957,420 @@ int main(int argc, char* argv[]) {
 
     std::string cmd = argv[1];
 
+    // Counters and phase times on stderr when the command finishes
+    StatsReport stats_report(has_flag(argc, argv, "--stats"));
+
+    // Exact terms shared by every command, optionally kept in a file between runs
+    std::string sequence_file = get_flag(argc, argv, "--sequence-cache", "");
+    if (!sequence_file.empty()) sequence_cache().attach(sequence_file);
+
     if (cmd == "count") {
-        if (argc < 3) { std::cerr << "Usage: " << argv[0] << " count <N>\n"; return 1; }
-        int N = std::stoi(argv[2]);
-        long long result = count_dp(N);
-        std::cout << "Number of tilings for a 2×" << N << " floor: " << result << "\n";
+        long long N = 0;
+        if (argc < 3 || !parse_decimal(argv[2], N)) {
+            std::cerr << "Usage: " << argv[0] << " count <N> [--method=auto|dp|rec|matpow|kitamasa] [--mod P] [--rows M] [--transfer-cache DIR] [--digits=H,T]"
+                      << "  (N >= 0)\n";
+            return 1;
+        }
+        std::string method = get_flag(argc, argv, "--method", "auto");
+        std::string mod = get_flag(argc, argv, "--mod", "");
+        if (!mod.empty() && !setup_modulus(mod)) return 1;
+        std::string digits = get_flag(argc, argv, "--digits", "");
+        size_t head = 0, tail = 0;
+        if (!digits.empty() && (!parse_digits_flag(digits, head, tail) || !mod.empty())) {
+            std::cerr << "Invalid --digits: " << digits << " (expected H,T, without --mod)\n";
+            return 1;
+        }
+        std::string rows_text = get_flag(argc, argv, "--rows", "2");
+        long long parsed_rows = 0;
+        if (!parse_decimal(rows_text, parsed_rows) || parsed_rows < 1 || parsed_rows > kMaxRows) {
+            std::cerr << "Invalid row count: " << rows_text << " (expected 1.." << kMaxRows << ")\n";
+            return 1;
+        }
+        int rows = int(parsed_rows);
+        if (rows != 2) {
+            // Only the broken-profile DP handles other heights
+            if (method != "auto" && method != "dp") {
+                std::cerr << "Method " << method << " only supports 2 rows; use --method=dp\n";
+                return 1;
+            }
+            std::string cache_dir = get_flag(argc, argv, "--transfer-cache", "");
+            if (!mod.empty()) {
+                ModInt result = count_rows<ModInt>(rows, N, cache_dir);
+                std::cout << "Number of tilings for a " << rows << "×" << N << " floor (mod " << mod << "): " << result << "\n";
+            } else if (!exact_board_in_reach(rows, N)) {
+                std::cerr << "An exact count for a " << rows << "×" << N << " floor would take well over "
+                          << "100 s (the work grows as N²·M²·2^M); use --mod P for its residue\n";
+                return 1;
+            } else {
+                std::string result = exact_board_count(rows, N, cache_dir);
+                if (!digits.empty()) result = digits_summary(result, head, tail);
+                std::cout << "Number of tilings for a " << rows << "×" << N << " floor: " << result << "\n";
+            }
+            return 0;
+        }
+        // A precomputed table answers without computing anything
+        std::string table_path = get_flag(argc, argv, "--table-file", "");
+        if (!table_path.empty()) {
+            TableFile table;
+            std::string error, result;
+            if (!table.open(table_path, error)) {
+                std::cerr << "Invalid table file " << table_path << ": " << error << "\n";
+                return 1;
+            }
+            uint64_t P = mod.empty() ? 0 : ModInt::modulus();
+            if (N >= 0 && uint64_t(N) < table.terms() && table.modulus() == P) {
+                if (!table.term(N, result)) {
+                    std::cerr << "Invalid table file " << table_path << ": corrupt index\n";
+                    return 1;
+                }
+                if (!mod.empty()) {
+                    std::cout << "Number of tilings for a 2×" << N << " floor (mod " << mod << "): " << result << "\n";
+                } else {
+                    if (!digits.empty()) result = digits_summary(result, head, tail);
+                    std::cout << "Number of tilings for a 2×" << N << " floor: " << result << "\n";
+                }
+                return 0;
+            }
+        }
+        if (method == "auto") method = auto_method(N, !mod.empty());
+
+        if (method != "dp" && method != "rec" && method != "matpow" && method != "kitamasa" && method != "table") {
+            std::cerr << "Unknown method: " << method << " (expected auto, dp, rec, matpow, kitamasa or table)\n";
+            return 1;
+        }
+        if (method == "table" && (N < 0 || N > kMaxLongLongN)) {
+            std::cerr << "Method table only covers N = 0.." << kMaxLongLongN << "\n";
+            return 1;
+        }
+        if (!mod.empty()) {
+            ModInt result = count_with<ModInt>(method, N);
+            std::cout << "Number of tilings for a 2×" << N << " floor (mod " << mod << "): " << result << "\n";
+        } else {
+            std::string result = digits.empty() ? exact_count(method, N)
+                                                : digits_summary(count_with<BigInt>(method, N), head, tail);
+            std::cout << "Number of tilings for a 2×" << N << " floor: " << result << "\n";
+        }
+
+    } else if (cmd == "count-batch") {
+        // One query per line: "N" or "N P"; --mod supplies P for bare lines
+        std::string path = (argc > 2 && argv[2][0] != '-') ? argv[2] : "-";
+        std::string default_mod = get_flag(argc, argv, "--mod", "");
+        uint64_t default_p = 0;
+        if (!default_mod.empty() && !parse_modulus(default_mod, default_p)) {
+            std::cerr << "Invalid modulus: " << default_mod << " (expected an odd integer in [3, 2^63))\n";
+            return 1;
+        }
+        std::ifstream file;
+        if (path != "-") {
+            file.open(path);
+            if (!file) { std::cerr << "Cannot open " << path << "\n"; return 1; }
+        }
+        std::istream& in = (path == "-") ? std::cin : file;
+
+        std::vector<CountQuery> queries;
+        std::string line;
+        for (long long line_no = 1; std::getline(in, line); line_no++) {
+            std::istringstream fields(line);
+            std::string n_text, p_text;
+            if (!(fields >> n_text)) continue;  // blank line
+            if (!(fields >> p_text)) p_text = default_mod;
+            CountQuery q{0, 0};
+            if (!parse_decimal(n_text, q.N) || (!p_text.empty() && !parse_modulus(p_text, q.P))) {
+                std::cerr << "Invalid query on line " << line_no << ": " << line
+                          << " (expected N [P], P an odd integer in [3, 2^63))\n";
+                return 1;
+            }
+            queries.push_back(q);
+        }
+
+        TableFile table;
+        std::string table_path = get_flag(argc, argv, "--table-file", ""), error;
+        if (!table_path.empty() && !table.open(table_path, error)) {
+            std::cerr << "Invalid table file " << table_path << ": " << error << "\n";
+            return 1;
+        }
+
+        OutBuf out;
+        for (const std::string& answer : count_batch(queries, table_path.empty() ? nullptr : &table)) {
+            out.put(answer);
+            out.put('\n');
+        }
 
     } else if (cmd == "enumerate") {
-        if (argc < 3) { std::cerr << "Usage: " << argv[0] << " enumerate <N>\n"; return 1; }
-        int N = std::stoi(argv[2]);
-        if (N > 6) {
-            std::cerr << "Warning: N=" << N << " may produce a very large number of tilings ("
-                      << count_dp(N) << "). Proceed? [y/N] ";
-            char c;
-            std::cin >> c;
-            if (c != 'y' && c != 'Y') return 0;
+        long long parsed_N = 0;
+        if (argc < 3 || !parse_decimal(argv[2], parsed_N) || parsed_N > INT_MAX / 2) {
+            std::cerr << "Usage: " << argv[0] << " enumerate <N> [--format=ascii|codes|bin] [--threads T] [--offset K] [--limit L] [--count-only] [--all]\n";
+            return 1;
+        }
+        int N = int(parsed_N);
+        std::string format = get_flag(argc, argv, "--format", "ascii");
+        if (format != "ascii" && format != "codes" && format != "bin") {
+            std::cerr << "Unknown format: " << format << " (expected ascii, codes or bin)\n";
+            return 1;
+        }
+        std::string threads_text = get_flag(argc, argv, "--threads", "1");
+        long long threads = 0;
+        if (!parse_decimal(threads_text, threads) || threads < 1 || threads > 1024) {
+            std::cerr << "Invalid thread count: " << threads_text << " (expected 1..1024)\n";
+            return 1;
         }
 
-        Enumerator en(N);
-        en.enumerate();
+        // A bounded slice, or just its size, is served from the ranking tables
+        std::string offset = get_flag(argc, argv, "--offset", "");
+        std::string limit = get_flag(argc, argv, "--limit", "");
+        bool count_only = has_flag(argc, argv, "--count-only");
+        bool all = has_flag(argc, argv, "--all");
+        if (N > kMaxUnguardedEnumerateN && limit.empty() && !count_only && !all) {
+            std::cerr << "A 2×" << N << " floor has " << exact_count(auto_method(N, false), N)
+                      << " tilings. Select some with --offset K --limit L, or pass --all to print every one.\n";
+            return 1;
+        }
+        if (!offset.empty() || !limit.empty() || count_only) {
+            long long max = LLONG_MAX;
+            if (!limit.empty() && !parse_decimal(limit, max)) {
+                std::cerr << "Invalid limit: " << limit << " (expected a count of tilings)\n";
+                return 1;
+            }
+            if (offset.empty()) offset = "0";
+            if (threads > 1)
+                std::cerr << "Note: --threads has no effect with --offset, --limit or --count-only; "
+                          << "the slice is unranked and written on one thread\n";
+            if (N <= kMaxLongLongN) return run_enumerate_slice<long long>(N, offset, max, format, count_only);
+            return run_enumerate_slice<BigInt>(N, offset, max, format, count_only);
+        }
+
+        // Full dumps and the parallel path number tilings in long long
+        if (N > kMaxLongLongN && (format == "bin" || threads > 1)) {
+            std::cerr << "--format=bin and --threads number tilings in 64 bits, so they need N <= " << kMaxLongLongN
+                      << " without --offset/--limit\n";
+            return 1;
+        }
+        if (threads > 1) {
+            OutBuf out;
+            if (format == "bin") {
+                write_tiling_header(out, N, uint64_t(count_dp(N)), 0);
+                parallel_enumerate(N, int(threads), out, [N](const Grid& grid, long long, std::string& chunk) {
+                    thread_local std::vector<uint64_t> words;
+                    words.resize(packed_words(N));
+                    pack_tiling(grid, words.data());
+                    chunk.append(reinterpret_cast<const char*>(words.data()), 8 * words.size());
+                });
+            } else if (format == "ascii") {
+                out.put("All tilings of a 2×" + std::to_string(N) + " floor (" +
+                        exact_count(auto_method(N, false), N) + " total):\n\n");
+                parallel_enumerate(N, int(threads), out, [N](const Grid& grid, long long index, std::string& chunk) {
+                    char digits[20];
+                    size_t len = std::to_chars(digits, digits + sizeof(digits), index).ptr - digits;
+                    size_t at = chunk.size();
+                    chunk.resize(at + tiling_text_size(N, len));
+                    chunk.resize(at + render_tiling(grid, digits, len, &chunk[at]));
+                });
+            } else {
+                parallel_enumerate(N, int(threads), out, [N](const Grid& grid, long long, std::string& chunk) {
+                    PackedTiling t(grid);
+                    for (int c = 0; c < N; c++) chunk.push_back(char('0' + t.move(c)));
+                    chunk.push_back('\n');
+                });
+            }
+        } else if (format == "bin") {
+            OutBuf out;
+            write_tiling_header(out, N, uint64_t(count_dp(N)), 0);
+            size_t bytes = 8 * packed_words(N);
+            for_each_packed_tiling(N, [&](const uint64_t* words) {
+                out.write(reinterpret_cast<const char*>(words), bytes);
+            });
+        } else if (format == "codes") {
+            // One packed tiling per line in its text form
+            OutBuf out;
+            std::string line(N, '0');
+            for_each_packed_tiling(N, [&](const uint64_t* words) {
+                for (int c = 0; c < N; c++) line[c] = char('0' + packed_move(words, c));
+                out.put(line);
+                out.put('\n');
+            });
+        } else if (format == "ascii") {
+            OutBuf out;
+            out.put("All tilings of a 2×" + std::to_string(N) + " floor (" +
+                    exact_count(auto_method(N, false), N) + " total):\n\n");
+            long long index = 0;
+            for_each_tiling(N, [&](const Grid& grid) {
+                print_tiling(grid, ++index, out);
+            });
+        }
+
+    } else if (cmd == "read-tilings") {
+        if (argc < 3) { std::cerr << "Usage: " << argv[0] << " read-tilings <file> [--format=codes|ascii|summary]\n"; return 1; }
+        std::string format = get_flag(argc, argv, "--format", "codes");
+        if (format != "codes" && format != "ascii" && format != "summary") {
+            std::cerr << "Unknown format: " << format << " (expected codes, ascii or summary)\n";
+            return 1;
+        }
+        TilingFile file;
+        std::string error;
+        if (!file.open(argv[2], error)) {
+            std::cerr << "Invalid tiling file " << argv[2] << ": " << error << "\n";
+            return 1;
+        }
+        int N = file.N();
+        OutBuf out;
+        if (format == "codes") {
+            std::string line(N, '0');
+            file.for_each([&](const uint64_t* words) {
+                for (int c = 0; c < N; c++) line[c] = char('0' + packed_move(words, c));
+                out.put(line);
+                out.put('\n');
+            });
+        } else if (format == "ascii") {
+            Grid grid(N);
+            long long index = (long long)file.first_rank();
+            file.for_each([&](const uint64_t* words) {
+                unpack_tiling(words, grid);
+                print_tiling(grid, ++index, out);
+            });
+        } else {
+            // Tile counts straight from the move codes
+            double sum = 0, sum_sq = 0;
+            file.for_each([&](const uint64_t* words) {
+                int singles = 0, profile = 0;
+                for (int c = 0; c < N; c++) {
+                    const ColumnMove& m = kMoves[profile][packed_move(words, c)];
+                    singles += (m.top == '1') + (m.bot == '1');
+                    profile = m.next;
+                }
+                sum += singles;
+                sum_sq += double(singles) * singles;
+            });
+            out.put(std::string(argv[2]) + ": " + std::to_string(file.count()) + " tilings of a 2×" +
+                    std::to_string(N) + " floor, ranks " + std::to_string(file.first_rank()) + " onward\n");
+            if (file.count() > 0) {
+                double mean = sum / file.count();
+                std::ostringstream os;
+                os << "1×1 tiles per tiling: mean " << mean << ", variance " << (sum_sq / file.count() - mean * mean)
+                   << "\n";
+                out.put(os.str());
+            }
+        }
 
-        std::cout << "All tilings of a 2×" << N << " floor (" << en.results.size() << " total):\n\n";
-        for (size_t i = 0; i < en.results.size(); i++) {
-            print_tiling(en.results[i], i + 1);
+    } else if (cmd == "unrank") {
+        long long N = 0;
+        if (argc < 4 || !parse_decimal(argv[2], N) || N > INT_MAX) {
+            std::cerr << "Usage: " << argv[0] << " unrank <N> <k> [--format=ascii|codes]  (N = 0.." << INT_MAX << ")\n";
+            return 1;
+        }
+        std::string format = get_flag(argc, argv, "--format", "ascii");
+        if (format != "ascii" && format != "codes") {
+            std::cerr << "Unknown format: " << format << " (expected ascii or codes)\n";
+            return 1;
+        }
+        if (N <= kMaxLongLongN) return run_unrank<long long>(int(N), argv[3], format);
+        return run_unrank<BigInt>(int(N), argv[3], format);
+
+    } else if (cmd == "rank") {
+        if (argc < 3) { std::cerr << "Usage: " << argv[0] << " rank <code>\n"; return 1; }
+        PackedTiling t;
+        if (!decode_tiling(argv[2], t)) {
+            std::cerr << "Invalid tiling code: " << argv[2] << "\n";
+            return 1;
+        }
+        if (t.N <= kMaxLongLongN) run_rank<long long>(t);
+        else run_rank<BigInt>(t);
+
+    } else if (cmd == "sample") {
+        long long parsed_N = 0, samples = 0;
+        if (argc < 4 || !parse_decimal(argv[2], parsed_N) || parsed_N > INT_MAX || !parse_decimal(argv[3], samples)) {
+            std::cerr << "Usage: " << argv[0] << " sample <N> <count> [--seed S] [--format=codes|ascii|summary]"
+                      << "  (N = 0.." << INT_MAX << ", count >= 0)\n";
+            return 1;
+        }
+        int N = int(parsed_N);
+        std::string format = get_flag(argc, argv, "--format", "codes");
+        if (format != "codes" && format != "ascii" && format != "summary") {
+            std::cerr << "Unknown format: " << format << " (expected codes, ascii or summary)\n";
+            return 1;
+        }
+        std::string seed = get_flag(argc, argv, "--seed", "");
+        std::mt19937_64 rng(seed.empty() ? std::random_device{}() : std::stoull(seed));
+
+        TilingSampler sampler(N);
+        std::vector<uint64_t> words(packed_words(N));
+        Grid grid(N);
+        OutBuf out;
+        std::string line(N, '0');
+        double sum = 0, sum_sq = 0;  // number of 1×1 tiles, for the summary
+
+        for (long long i = 0; i < samples; i++) {
+            sampler.sample(rng, words.data());
+            if (format == "codes") {
+                for (int c = 0; c < N; c++) line[c] = char('0' + packed_move(words.data(), c));
+                out.put(line);
+                out.put('\n');
+            } else if (format == "ascii") {
+                unpack_tiling(words.data(), grid);
+                print_tiling(grid, i + 1, out);
+            } else {
+                int singles = 0, profile = 0;
+                for (int c = 0; c < N; c++) {
+                    const ColumnMove& m = kMoves[profile][packed_move(words.data(), c)];
+                    singles += (m.top == '1') + (m.bot == '1');
+                    profile = m.next;
+                }
+                sum += singles;
+                sum_sq += double(singles) * singles;
+            }
+        }
+
+        if (format == "summary" && samples > 0) {
+            double mean = sum / samples;
+            std::cout << "Sampled " << samples << " tilings of a 2×" << N << " floor\n"
+                      << "1×1 tiles per tiling: mean " << mean
+                      << ", variance " << (sum_sq / samples - mean * mean) << "\n";
         }
 
     } else if (cmd == "verify") {
-        if (argc < 3) { std::cerr << "Usage: " << argv[0] << " verify <N>\n"; return 1; }
+        if (argc < 3) {
+            std::cerr << "Usage: " << argv[0] << " verify <N> [--engines=LIST] [--threads T] [--mod P] [--fail-fast]\n";
+            return 1;
+        }
+
+        // Any of the differential flags selects the multi-engine runner
+        std::string engines_text = get_flag(argc, argv, "--engines", "");
+        std::string threads_text = get_flag(argc, argv, "--threads", "");
+        std::string mod = get_flag(argc, argv, "--mod", "");
+        bool fail_fast = has_flag(argc, argv, "--fail-fast");
+        if (!engines_text.empty() || !threads_text.empty() || !mod.empty() || fail_fast) {
+            long long N = 0, threads = 1;
+            if (!parse_decimal(argv[2], N)) {
+                std::cerr << "Invalid N: " << argv[2] << "\n";
+                return 1;
+            }
+            if (!threads_text.empty() && (!parse_decimal(threads_text, threads) || threads < 1 || threads > 1024)) {
+                std::cerr << "Invalid thread count: " << threads_text << "\n";
+                return 1;
+            }
+            if (mod.empty()) mod = "998244353";
+            if (!setup_modulus(mod)) return 1;
+            std::vector<std::string> engines;
+            if (engines_text.empty()) engines_text = "rec,dp,matpow,kitamasa,table,enum,closedform";
+            for (size_t at = 0; at <= engines_text.size();) {
+                size_t comma = std::min(engines_text.find(',', at), engines_text.size());
+                std::string e = engines_text.substr(at, comma - at);
+                if (std::find(std::begin(kVerifyEngines), std::end(kVerifyEngines), e) == std::end(kVerifyEngines)) {
+                    std::cerr << "Unknown engine: " << e << " (expected rec, dp, matpow, kitamasa, table, enum or closedform)\n";
+                    return 1;
+                }
+                engines.push_back(e);
+                at = comma + 1;
+            }
+
+            std::cout << "Differential check of a_0..a_" << N << " on " << threads << " thread"
+                      << (threads == 1 ? "" : "s") << ": " << engines_text << "\n"
+                      << "Types: long long (N <= " << kMaxLongLongN << "), mod " << mod << ", bignum\n";
+            DifferentialVerifier verifier(N, engines, ModInt::modulus(), fail_fast);
+            bool ok = verifier.run(int(threads));
+            verifier.print_summary(std::cout);
+            std::cout << (ok ? "\nAll checks passed!\n" : "\nSome checks FAILED!\n");
+            return ok ? 0 : 1;
+        }
         int N = std::stoi(argv[2]);
 
         std::cout << "Verifying recurrence vs bitmask DP for N=0.." << N << ":\n\n";
@@ -297,17 +5380,29 @@ int main(int argc, char* argv[]) {
                   << "Match?\n";
         std::cout << std::string(50, '-') << "\n";
 
+        // One DP pass gives every a_i; the recurrence side comes from the
+        // sequence cache and continues by rolling three terms past its end
         bool all_ok = true;
-        for (int i = 0; i <= N; i++) {
-            long long rec = count_recurrence(i);
-            long long dp = count_dp(i);
-            bool match = (rec == dp);
-            if (!match) all_ok = false;
-
-            std::cout << std::setw(5) << i << " | "
-                      << std::setw(15) << rec << " | "
-                      << std::setw(15) << dp << " | "
-                      << (match ? "OK" : "MISMATCH") << "\n";
+        std::vector<BigInt> dp = count_dp_prefixes<BigInt>(N);
+        SequenceCache& seq = sequence_cache();
+        BigInt t0, t1, t2;
+        {
+            PhaseTimer timer(kPhaseCounting);
+            for (int i = 0; i <= N; i++) {
+                if (i < kSequenceCacheTerms) {
+                    t2 = seq.get(i);
+                } else {
+                    if (i == kSequenceCacheTerms) {
+                        t0 = seq.get(i - 3);
+                        t1 = seq.get(i - 2);
+                        t2 = seq.get(i - 1);
+                    }
+                    recurrence_step(t0, t1, t2);
+                    std::swap(t0, t1);
+                    std::swap(t1, t2);
+                }
+                if (!verify_row(i, t2, dp[i])) all_ok = false;
+            }
         }
 
         std::cout << "\nVerifying against full enumeration for N=0..6:\n\n";
@@ -318,9 +5413,8 @@ int main(int argc, char* argv[]) {
         std::cout << std::string(50, '-') << "\n";
 
         for (int i = 0; i <= std::min(N, 6); i++) {
-            Enumerator en(i);
-            en.enumerate();
-            long long en_count = en.results.size();
+            long long en_count = 0;
+            for_each_tiling(i, [&](const Grid&) { en_count++; });
             long long rec = count_recurrence(i);
             bool match = (en_count == rec);
             if (!match) all_ok = false;
@@ -336,16 +5430,197 @@ int main(int argc, char* argv[]) {
         else
             std::cout << "\nSome checks FAILED!\n";
 
+    } else if (cmd == "bench") {
+        std::string min_time_flag = get_flag(argc, argv, "--min-time", "0.1");
+        char* end = nullptr;
+        double min_time = std::strtod(min_time_flag.c_str(), &end);
+        if (end == min_time_flag.c_str() || *end || !(min_time >= 0 && min_time <= 3600)) {
+            std::cerr << "Invalid --min-time: " << min_time_flag << " (expected 0..3600 seconds)\n";
+            return 1;
+        }
+        BenchRunner runner(min_time, get_flag(argc, argv, "--filter", ""));
+        run_benchmarks(runner);
+        runner.print(std::cout);
+
+    } else if (cmd == "serve") {
+        TilingServer server;
+        std::string socket_path = get_flag(argc, argv, "--socket", "");
+        if (!socket_path.empty()) return serve_socket(server, socket_path);
+        if (!serve_stream(server, 0, 1)) {
+            std::cerr << "Read error: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+
+    } else if (cmd == "build-table") {
+        long long N = 0;
+        if (argc < 4 || !parse_decimal(argv[2], N)) {
+            std::cerr << "Usage: " << argv[0] << " build-table <N> <file> [--mod P]  (N >= 0)\n";
+            return 1;
+        }
+        std::string mod = get_flag(argc, argv, "--mod", "");
+        if (!mod.empty() && !setup_modulus(mod)) return 1;
+        if (!build_table_file(argv[3], N, mod.empty() ? 0 : ModInt::modulus())) {
+            std::cerr << "Cannot write " << argv[3] << "\n";
+            return 1;
+        }
+        std::cout << "Wrote a_0 through a_" << N << (mod.empty() ? "" : " (mod " + mod + ")") << " to " << argv[3] << "\n";
+
+    } else if (cmd == "check-table") {
+        if (argc < 3) { std::cerr << "Usage: " << argv[0] << " check-table <file>\n"; return 1; }
+        TableFile table;
+        std::string error, last;
+        if (!table.open(argv[2], error)) {
+            std::cerr << "Invalid table file " << argv[2] << ": " << error << "\n";
+            return 1;
+        }
+        // The checksum covers every byte; the last term is also recomputed
+        long long N = (long long)table.terms() - 1;
+        bool ok = table.check_payload() && table.term(N, last);
+        if (ok && table.modulus() != 0) {
+            ModInt::set_modulus(table.modulus());
+            ok = last == std::to_string(count_kitamasa<ModInt>(N).value());
+        } else if (ok) {
+            ok = last == exact_count("kitamasa", N);
+        }
+        std::cout << argv[2] << ": a_0 through a_" << N;
+        if (table.modulus() != 0) std::cout << " (mod " << table.modulus() << ")";
+        std::cout << (ok ? ", OK\n" : ", FAILED\n");
+        if (!ok) return 1;
+
+    } else if (cmd == "merge-table") {
+        // Every flag takes a value, so the rest are shard files
+        std::vector<std::string> files;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.compare(0, 2, "--") != 0) files.push_back(arg);
+            else if (arg.find('=') == std::string::npos) i++;
+        }
+        if (files.empty()) {
+            std::cerr << "Usage: " << argv[0] << " merge-table <shard>... [--from A] [--to B] [--mod P] [--format=text|csv|tsv|binary]\n";
+            return 1;
+        }
+        std::string mod = get_flag(argc, argv, "--mod", "");
+        if (!mod.empty() && !setup_modulus(mod)) return 1;
+        TableFormat format;
+        std::string format_name = get_flag(argc, argv, "--format", "text");
+        if (!parse_table_format(format_name, format)) {
+            std::cerr << "Unknown format: " << format_name << " (expected text, csv, tsv or binary)\n";
+            return 1;
+        }
+        long long range[2] = {-1, -1};
+        const char* names[2] = {"--from", "--to"};
+        for (int j = 0; j < 2; j++) {
+            std::string text = get_flag(argc, argv, names[j], "");
+            if (!text.empty() && !parse_row_index(text, range[j])) {
+                std::cerr << "Invalid " << names[j] + 2 << ": " << text << "\n";
+                return 1;
+            }
+        }
+        if (!mod.empty()) return merge_table<ModInt>(files, format, mod, range[0], range[1]);
+        if (format == TableFormat::Binary) return merge_table<BigInt>(files, format, mod, range[0], range[1]);
+        return merge_table<DecimalBig>(files, format, mod, range[0], range[1]);
+
+    } else if (cmd == "distribution") {
+        if (argc < 3) {
+            std::cerr << "Usage: " << argv[0] << " distribution <N> [--threads T] [--format=text|csv|tsv]\n";
+            return 1;
+        }
+        long long N = 0;
+        if (!parse_decimal(argv[2], N) || N > 1000000) {
+            std::cerr << "Invalid N: " << argv[2] << " (expected 0..1000000)\n";
+            return 1;
+        }
+        std::string threads_text = get_flag(argc, argv, "--threads", "1");
+        long long threads = 0;
+        if (!parse_decimal(threads_text, threads) || threads < 1 || threads > 1024) {
+            std::cerr << "Invalid thread count: " << threads_text << "\n";
+            return 1;
+        }
+        TableFormat format;
+        std::string format_name = get_flag(argc, argv, "--format", "text");
+        if (!parse_table_format(format_name, format) || format == TableFormat::Binary) {
+            std::cerr << "Unknown format: " << format_name << " (expected text, csv or tsv)\n";
+            return 1;
+        }
+        // Every coefficient is at most a_N, so long long holds them while a_N does
+        if (N <= kMaxLongLongN) return run_distribution<long long>(int(N), int(threads), format);
+        return run_distribution<BigInt>(int(N), int(threads), format);
+
+    } else if (cmd == "closedform") {
+        long long N = 0;
+        if (argc < 3 || !parse_decimal(argv[2], N)) {
+            std::cerr << "Usage: " << argv[0] << " closedform <N> [--precision P] [--format=text|value]  (N >= 0)\n";
+            return 1;
+        }
+        std::string precision = get_flag(argc, argv, "--precision", "50");
+        long long digits = 0;
+        if (!parse_decimal(precision, digits) || digits < 1 || digits > 100000000) {
+            std::cerr << "Invalid precision: " << precision << " (expected 1..100000000 digits)\n";
+            return 1;
+        }
+        std::string format = get_flag(argc, argv, "--format", "text");
+        if (format != "text" && format != "value") {
+            std::cerr << "Unknown format: " << format << " (expected text or value)\n";
+            return 1;
+        }
+        return run_closedform(N, size_t(digits), format);
+
     } else if (cmd == "table") {
-        if (argc < 3) { std::cerr << "Usage: " << argv[0] << " table <N>\n"; return 1; }
-        int N = std::stoi(argv[2]);
+        // `table N` is a_0..a_N; --from and --to select any range
+        std::string to_text = get_flag(argc, argv, "--to", (argc > 2 && argv[2][0] != '-') ? argv[2] : "");
+        if (to_text.empty()) {
+            std::cerr << "Usage: " << argv[0] << " table <N> [--from A] [--to B] [--shard i/k] [--mod P] [--format=text|csv|tsv|binary]\n";
+            return 1;
+        }
+        std::string from_text = get_flag(argc, argv, "--from", "0");
+        long long from = 0, N = 0;
+        if (!parse_decimal(from_text, from) || !parse_decimal(to_text, N)) {
+            std::cerr << "Usage: " << argv[0] << " table <N> [--from A] [--to B] [--shard i/k] [--mod P] [--format=text|csv|tsv|binary]"
+                      << "  (A, B >= 0)\n";
+            return 1;
+        }
+        if (from > N) {
+            std::cerr << "Invalid range: a_" << from << " through a_" << N << "\n";
+            return 1;
+        }
+        std::string shard = get_flag(argc, argv, "--shard", "");
+        if (!shard.empty()) {
+            long long i = 0, k = 0;
+            if (!parse_shard(shard, i, k) || k > N - from + 1) {
+                std::cerr << "Invalid shard: " << shard << " (expected i/k with 1 <= i <= k <= "
+                          << N - from + 1 << ")\n";
+                return 1;
+            }
+            shard_range(from, N, i, k, from, N);
+        }
+        std::string mod = get_flag(argc, argv, "--mod", "");
+        if (!mod.empty() && !setup_modulus(mod)) return 1;
+        TableFormat format;
+        std::string format_name = get_flag(argc, argv, "--format", "text");
+        if (!parse_table_format(format_name, format)) {
+            std::cerr << "Unknown format: " << format_name << " (expected text, csv, tsv or binary)\n";
+            return 1;
+        }
 
-        std::cout << "Tiling counts a_0 through a_" << N << ":\n\n";
-        std::cout << std::setw(5) << "N" << " | " << std::setw(20) << "a_N" << "\n";
-        std::cout << std::string(30, '-') << "\n";
+        OutBuf out;
+        TableWriter w{out, format, std::string()};
+        w.header(from, N, mod);
 
-        for (int i = 0; i <= N; i++) {
-            std::cout << std::setw(5) << i << " | " << std::setw(20) << count_recurrence(i) << "\n";
+        // The first three rows come from one Kitamasa jump, the rest from the recurrence
+        if (!mod.empty()) {
+            auto t = kitamasa_terms<ModInt>(from);
+            stream_table(w, from, N, t[0], t[1], t[2]);
+        } else {
+            // Rows up to a_kMaxLongLongN from the compile-time table, then BigInt
+            for (long long i = from; i <= std::min(N, kMaxLongLongN); i++) w.term(i, kSmallCounts[i]);
+            long long start = std::max(from, kMaxLongLongN + 1);
+            if (N >= start) {
+                auto t = kitamasa_terms<BigInt>(start);
+                if (format == TableFormat::Binary)
+                    stream_table(w, start, N, t[0], t[1], t[2]);
+                else
+                    stream_table(w, start, N, DecimalBig(t[0]), DecimalBig(t[1]), DecimalBig(t[2]));
+            }
         }
 
     } else {